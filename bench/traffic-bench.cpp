@@ -0,0 +1,434 @@
+/*
+ * Traffic Management UAV.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <new>
+#include <cstdlib>
+#include <getopt.h>
+#include <opencv2/opencv.hpp>
+
+#include "../include/detect.h"
+#include "../include/aux.h"
+#include "../include/config.h"
+#include "../include/classifier.h"
+#include "../include/hoggrid.h"
+#include "../include/occupancy.h"
+#include "../include/pyramid.h"
+#include "../include/tracks.h"
+#include "../include/tracker.h"
+#include "../include/bgtracking.h"
+
+using namespace std;
+using namespace cv;
+using namespace cv::ml;
+using namespace std::chrono;
+
+/*
+ * Allocations counter. Only the C++ allocations are seen: the cv::Mat
+ * buffers come from cv::fastMalloc and are not counted.
+ */
+static atomic<unsigned long> allocs(0);
+static atomic<unsigned long> alloc_bytes(0);
+
+void* operator new(size_t size)
+{
+    allocs.fetch_add(1, memory_order_relaxed);
+    alloc_bytes.fetch_add(size, memory_order_relaxed);
+    void *p = malloc(size ? size:1);
+    if (!p)
+        throw bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const nothrow_t&) noexcept
+{
+    allocs.fetch_add(1, memory_order_relaxed);
+    alloc_bytes.fetch_add(size, memory_order_relaxed);
+    return malloc(size ? size:1);
+}
+
+void* operator new[](size_t size, const nothrow_t&) noexcept
+{
+    return operator new(size, nothrow);
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void *p, const nothrow_t&) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void *p, const nothrow_t&) noexcept
+{
+    free(p);
+}
+
+// Runs op until min_time and prints a JSON line with the per operation costs
+void Benchmark(string name, string input, double min_time, function<void()> op)
+{
+    op();                                                               // Warm up (buffers, pool threads)
+    
+    unsigned long iterations = 1;
+    double elapsed = 0;
+    unsigned long n_allocs = 0;
+    unsigned long n_bytes = 0;
+    while(true)
+    {
+        unsigned long a0 = allocs.load();
+        unsigned long b0 = alloc_bytes.load();
+        auto t0 = steady_clock::now();
+        for(unsigned long i=0;i<iterations;i++)
+            op();
+        elapsed = duration_cast<nanoseconds>(steady_clock::now() - t0).count()/1e9;
+        n_allocs = allocs.load() - a0;
+        n_bytes = alloc_bytes.load() - b0;
+        if ((elapsed >= min_time) or (iterations >= (1ul << 30)))
+            break;
+        iterations *= (elapsed < min_time/10)? 10:2;
+    }
+    
+    cout << "{\"benchmark\":\"" << name << "\",\"input\":\"" << input
+         << "\",\"iterations\":" << iterations
+         << ",\"ns_per_op\":" << elapsed*1e9/iterations
+         << ",\"allocs_per_op\":" << double(n_allocs)/iterations
+         << ",\"bytes_per_op\":" << double(n_bytes)/iterations << "}" << endl;
+}
+
+// Textured background with dark and bright cars, and the same scene moved
+void SyntheticFrames(Size size, int n_cars, vector<Rect> &rois, Mat &frame0, Mat &frame1, vector<Rect> &cars)
+{
+    RNG rng(12345);
+    Mat noise(size.height + 20, size.width + 20, CV_8UC1);
+    rng.fill(noise, RNG::UNIFORM, 0, 255);
+    GaussianBlur(noise, noise, Size(0, 0), 3);
+    normalize(noise, noise, 40, 200, NORM_MINMAX);
+    
+    cars.clear();
+    for(int i=0;i<n_cars;i++)
+    {
+        // Most cars on the searched lanes (ROIs), vertical as the detection expects
+        Rect roi = rois[i%rois.size()];
+        Rect r = Rect(rng.uniform(roi.x, roi.x + roi.width - 25) + 10,
+                      rng.uniform(roi.y, max(roi.y + 1, roi.y + roi.height - 50)) + 10, 25, 50);
+        Scalar color = Scalar(rng.uniform(0, 2)? 230:20);
+        rectangle(noise, r, color, CV_FILLED);
+        rectangle(noise, Rect(r.x + 4, r.y + 12, 17, 14), Scalar(110), CV_FILLED);
+        cars.push_back(r - Point(10, 10));
+    }
+    
+    Mat bgr;
+    cvtColor(noise, bgr, CV_GRAY2BGR);
+    frame0 = bgr(Rect(10, 10, size.width, size.height)).clone();
+    frame1 = bgr(Rect(12, 11, size.width, size.height)).clone();
+}
+
+// Linear SVM with the size of the detector, trained on random data
+Ptr<SVM> SyntheticSVM(int descriptor_size)
+{
+    RNG rng(54321);
+    Mat samples(40, descriptor_size, CV_32FC1);
+    rng.fill(samples, RNG::UNIFORM, 0, 0.2);
+    Mat labels(40, 1, CV_32SC1);
+    for(int i=0;i<40;i++)
+    {
+        labels.at<int>(i) = (i%2)? 1:-1;
+        if (i%2)
+            samples.row(i) += 0.05;
+    }
+    
+    Ptr<SVM> svm = SVM::create();
+    svm->setType(SVM::C_SVC);
+    svm->setKernel(SVM::LINEAR);
+    svm->train(samples, ROW_SAMPLE, labels);
+    
+    return svm;
+}
+
+void RunBenchmarks(string input, Mat &frame0, Mat &frame1, vector<Rect> &rois, vector<Rect> &car_rects,
+                   LinearCarClassifier &classifier, double min_time)
+{
+    Config config;
+    Setup(config, frame0);
+    SensorsData sensors_data;
+    ReadSensors(sensors_data);
+    
+    Mat gray0;
+    Mat gray1;
+    cvtColor(frame0, gray0, CV_BGR2GRAY);
+    cvtColor(frame1, gray1, CV_BGR2GRAY);
+    FramePyramid pyramid0(config);
+    FramePyramid pyramid1(config);
+    pyramid0.Build(gray0);
+    pyramid1.Build(gray1);
+    
+    TrackTable tracks(config, sensors_data);
+    for(unsigned int i=0;i<car_rects.size();i++)
+        tracks.Add(car_rects[i]);
+    OccupancyGrid occupancy(frame0.size());
+    occupancy.Build(tracks);
+    
+    // HOG of one window
+    Mat window = gray0(Rect(rois[0].x, rois[0].y, config.sliding_window_height, config.sliding_window_width)).clone();
+    Benchmark("getHOGDescriptors", input, min_time, [&]()
+    {
+        getHOGDescriptors(window, config, VERTICAL_SEARCH);
+    });
+    
+    // Variance of every window position of the first ROI, one per operation
+    Mat sum;
+    Mat sqsum;
+    Mat roi_image = gray0(rois[0]);
+    integral(roi_image, sum, sqsum);
+    vector<Rect> windows;
+    for(int y=0;y+config.sliding_window_width<=rois[0].height;y+=config.sliding_window_vertical_step)
+        for(int x=0;x+config.sliding_window_height<=rois[0].width;x+=config.sliding_window_horizontal_step)
+            windows.push_back(Rect(x, y, config.sliding_window_height, config.sliding_window_width));
+    unsigned int w = 0;
+    volatile double variance_sink = 0;
+    Benchmark("CalcVariance", input, min_time, [&]()
+    {
+        variance_sink = CalcVariance(sum, sqsum, windows[w]);
+        w = (w + 1 == windows.size())? 0:w + 1;
+    });
+    
+    // Overlapping candidates around every car, as the sliding windows give them
+    RNG rng(777);
+    vector<Rect> candidates;
+    for(unsigned int i=0;i<car_rects.size();i++)
+        for(int k=0;k<8;k++)
+            candidates.push_back(car_rects[i] + Point(rng.uniform(-5, 6), rng.uniform(-5, 6)));
+    Benchmark("NonMaximaSupression", input, min_time, [&]()
+    {
+        NonMaximaSupression(candidates);
+    });
+    
+    // Detection over the lanes ROIs, with no tracked cars (full search)
+    TrackTable detected(config, sensors_data);
+    OccupancyGrid empty_occupancy(frame0.size());
+    empty_occupancy.Build(detected);
+    Benchmark("DetectCars", input, min_time, [&]()
+    {
+        detected.Clear();
+        DetectCars(pyramid0, classifier, config, detected, empty_occupancy, rois, VERTICAL_SEARCH);
+    });
+    
+    Benchmark("DetectKeyPoints", input, min_time, [&]()
+    {
+        DetectKeyPoints(gray0, config);
+    });
+    
+    vector<Point2f> all_keypoints = DetectKeyPoints(gray0, config);
+    vector<Point2f> keypoints;
+    keypoints.reserve(all_keypoints.size());
+    Benchmark("ClassifingKeyPoints", input, min_time, [&]()
+    {
+        keypoints.assign(all_keypoints.begin(), all_keypoints.end());
+        ClassifingKeyPoints(keypoints, occupancy);
+    });
+    
+    // The tracking alternates the frames pair, so the keypoints go back and forth
+    BGTracking bg_tracking(keypoints, config);
+    bool forward = true;
+    Benchmark("BGTracking::Update", input, min_time, [&]()
+    {
+        if (forward)
+            bg_tracking.Update(pyramid0, pyramid1, frame1, false);
+        else
+            bg_tracking.Update(pyramid1, pyramid0, frame0, false);
+        forward = !forward;
+    });
+    
+    // Car::Update, with the optical flow already computed
+    vector<Point2f> moved_keypoints(tracks.getAllKeyPoints());
+    for(unsigned int i=0;i<moved_keypoints.size();i++)
+        moved_keypoints[i] += Point2f(2, 1);
+    vector<Point2f> original_keypoints(tracks.getAllKeyPoints());
+    vector<uchar> status(moved_keypoints.size(), 1);
+    forward = true;
+    Benchmark("TrackTable::Update", input, min_time, [&]()
+    {
+        const vector<Point2f> &next = forward? moved_keypoints:original_keypoints;
+        for(int i=0;i<tracks.getSize();i++)
+            tracks.Update(i, &next[i*CAR_KEYPOINTS], &status[i*CAR_KEYPOINTS], bg_tracking, frame1, false);
+        forward = !forward;
+    });
+    
+    // Background and cars optical flow in one pass (the lost cars are restored)
+    TrackerBatch tracker(config);
+    TrackTable batch_tracks = tracks;
+    forward = true;
+    Benchmark("TrackerBatch::Update", input, min_time, [&]()
+    {
+        if (batch_tracks.getSize() != tracks.getSize())
+            batch_tracks = tracks;
+        if (forward)
+            tracker.Update(pyramid0, pyramid1, bg_tracking, batch_tracks, frame1, false);
+        else
+            tracker.Update(pyramid1, pyramid0, bg_tracking, batch_tracks, frame0, false);
+        forward = !forward;
+    });
+    
+    Benchmark("FramePyramid::Build", input, min_time, [&]()
+    {
+        pyramid1.Build(gray1);
+    });
+}
+
+void Usage(char *name)
+{
+    cout << "Usage: " << name << " [options]" << endl;
+    cout << "  -i, --video FILE       Also run over the first two frames of a recorded video" << endl;
+    cout << "  -s, --svm FILE         Trained SVM (hog-svm-cars.xml, or a synthetic one if missing)" << endl;
+    cout << "  -d, --densities LIST   Cars of the synthetic frames (0,10,50 by default)" << endl;
+    cout << "  -t, --min-time SEC     Minimum time of each benchmark (0.5 by default)" << endl;
+    cout << "  -h, --help             Show this help" << endl;
+}
+
+int main(int argc, char **argv)
+{
+    string video_path;
+    string svm_path = "hog-svm-cars.xml";
+    string densities = "0,10,50";
+    double min_time = 0.5;
+    
+    const struct option long_options[] =
+    {
+        {"video", required_argument, 0, 'i'},
+        {"svm", required_argument, 0, 's'},
+        {"densities", required_argument, 0, 'd'},
+        {"min-time", required_argument, 0, 't'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+    
+    int opt;
+    while((opt = getopt_long(argc, argv, "i:s:d:t:h", long_options, 0)) != -1)
+    {
+        switch(opt)
+        {
+            case 'i':
+                video_path = optarg;
+                break;
+            case 's':
+                svm_path = optarg;
+                break;
+            case 'd':
+                densities = optarg;
+                break;
+            case 't':
+                min_time = atof(optarg);
+                break;
+            case 'h':
+                Usage(argv[0]);
+                return 0;
+            default:
+                Usage(argv[0]);
+                return -1;
+        }
+    }
+    
+    // Same classifier of traffic-man when available, so the detection cost is comparable
+    Ptr<SVM> svm;
+    if (ifstream(svm_path.c_str()).good())
+        svm = SVM::load<SVM>(svm_path);
+    else
+    {
+        HOGGrid grid;
+        svm = SyntheticSVM(grid.getDescriptorSize(50/HOG_CELL_SIZE, 25/HOG_CELL_SIZE));
+        cerr << svm_path << " not found, using a synthetic SVM" << endl;
+    }
+    LinearCarClassifier classifier(svm);
+    
+    Size size(1280, 720);
+    vector<Rect> rois;
+    rois.push_back(Rect(200, 0, size.width-400, 100));
+    rois.push_back(Rect(200, size.height-100, size.width-400, 100));
+    
+    stringstream list(densities);
+    string item;
+    while(getline(list, item, ','))
+    {
+        Mat frame0;
+        Mat frame1;
+        vector<Rect> cars;
+        SyntheticFrames(size, atoi(item.c_str()), rois, frame0, frame1, cars);
+        RunBenchmarks("synthetic-" + item, frame0, frame1, rois, cars, classifier, min_time);
+    }
+    
+    if (!video_path.empty())
+    {
+        VideoCapture cap(video_path);
+        Mat frame0;
+        Mat frame1;
+        cap >> frame0;
+        cap >> frame1;
+        if (frame0.empty() or frame1.empty())
+        {
+            cout << "Error reading the video " << video_path << endl;
+            return -1;
+        }
+        
+        // The tracks are the cars detected in the first frame
+        Config config;
+        Setup(config, frame0);
+        SensorsData sensors_data;
+        ReadSensors(sensors_data);
+        Mat gray0;
+        cvtColor(frame0, gray0, CV_BGR2GRAY);
+        FramePyramid pyramid(config);
+        pyramid.Build(gray0);
+        TrackTable detected(config, sensors_data);
+        OccupancyGrid occupancy(frame0.size());
+        occupancy.Build(detected);
+        vector<Rect> frame_roi(1, Rect(0, 0, frame0.cols, frame0.rows));
+        DetectCars(pyramid, classifier, config, detected, occupancy, frame_roi, VERTICAL_SEARCH);
+        vector<Rect> cars;
+        for(int i=0;i<detected.getSize();i++)
+            cars.push_back(detected.getRect(i));
+        
+        vector<Rect> video_rois;
+        video_rois.push_back(Rect(200, 0, frame0.cols-400, 100));
+        video_rois.push_back(Rect(200, frame0.rows-100, frame0.cols-400, 100));
+        RunBenchmarks("recorded", frame0, frame1, video_rois, cars, classifier, min_time);
+    }
+    
+    return 0;
+}
@@ -170,37 +170,8 @@ int8_t I2Cdev::readWord(uint8_t devAddr, uint8_t regAddr, uint16_t *data, uint16
  * @param timeout Optional read timeout in milliseconds (0 to disable, leave off to use default class value in I2Cdev::readTimeout)
  * @return Number of bytes read (-1 indicates failure)
  */
-int8_t I2Cdev::readBytes(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t *data, uint16_t timeout) {
-    int8_t count = 0;
-    int fd = open("/dev/i2c-1", O_RDWR);
-
-    if (fd < 0) {
-        fprintf(stderr, "Failed to open device: %s\n", strerror(errno));
-        return(-1);
-    }
-    if (ioctl(fd, I2C_SLAVE, devAddr) < 0) {
-        fprintf(stderr, "Failed to select device: %s\n", strerror(errno));
-        close(fd);
-        return(-1);
-    }
-    if (write(fd, &regAddr, 1) != 1) {
-        fprintf(stderr, "Failed to write reg: %s\n", strerror(errno));
-        close(fd);
-        return(-1);
-    }
-    count = read(fd, data, length);
-    if (count < 0) {
-        fprintf(stderr, "Failed to read device(%d): %s\n", count, ::strerror(errno));
-        close(fd);
-        return(-1);
-    } else if (count != length) {
-        fprintf(stderr, "Short read  from device, expected %d, got %d\n", length, count);
-        close(fd);
-        return(-1);
-    }
-    close(fd);
-
-    return count;
+int I2Cdev::readBytes(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t *data, uint16_t timeout) {
+    return getBus().readBytes(devAddr, regAddr, length, data);
 }
 
 /** Read multiple words from a 16-bit device register.
@@ -335,40 +306,16 @@ bool I2Cdev::writeWord(uint8_t devAddr, uint8_t regAddr, uint16_t data) {
  * @return Status of operation (true = success)
  */
 bool I2Cdev::writeBytes(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t* data) {
-    int8_t count = 0;
     uint8_t buf[128];
-    int fd;
 
     if (length > 127) {
         fprintf(stderr, "Byte write count (%d) > 127\n", length);
         return(FALSE);
     }
 
-    fd = open("/dev/i2c-1", O_RDWR);
-    if (fd < 0) {
-        fprintf(stderr, "Failed to open device: %s\n", strerror(errno));
-        return(FALSE);
-    }
-    if (ioctl(fd, I2C_SLAVE, devAddr) < 0) {
-        fprintf(stderr, "Failed to select device: %s\n", strerror(errno));
-        close(fd);
-        return(FALSE);
-    }
     buf[0] = regAddr;
     memcpy(buf+1,data,length);
-    count = write(fd, buf, length+1);
-    if (count < 0) {
-        fprintf(stderr, "Failed to write device(%d): %s\n", count, ::strerror(errno));
-        close(fd);
-        return(FALSE);
-    } else if (count != length+1) {
-        fprintf(stderr, "Short write to device, expected %d, got %d\n", length+1, count);
-        close(fd);
-        return(FALSE);
-    }
-    close(fd);
-
-    return TRUE;
+    return getBus().write(devAddr, buf, length+1);
 }
 
 /** Write multiple words to a 16-bit device register.
@@ -379,9 +326,8 @@ bool I2Cdev::writeBytes(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_
  * @return Status of operation (true = success)
  */
 bool I2Cdev::writeWords(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint16_t* data) {
-    int8_t count = 0;
     uint8_t buf[128];
-    int i, fd;
+    int i;
 
     // Should do potential byteswap and call writeBytes() really, but that
     // messes with the callers buffer
@@ -391,33 +337,12 @@ bool I2Cdev::writeWords(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint16
         return(FALSE);
     }
 
-    fd = open("/dev/i2c-0", O_RDWR);
-    if (fd < 0) {
-        fprintf(stderr, "Failed to open device: %s\n", strerror(errno));
-        return(FALSE);
-    }
-    if (ioctl(fd, I2C_SLAVE, devAddr) < 0) {
-        fprintf(stderr, "Failed to select device: %s\n", strerror(errno));
-        close(fd);
-        return(FALSE);
-    }
     buf[0] = regAddr;
     for (i = 0; i < length; i++) {
         buf[i*2+1] = data[i] >> 8;
         buf[i*2+2] = data[i];
     }
-    count = write(fd, buf, length*2+1);
-    if (count < 0) {
-        fprintf(stderr, "Failed to write device(%d): %s\n", count, ::strerror(errno));
-        close(fd);
-        return(FALSE);
-    } else if (count != length*2+1) {
-        fprintf(stderr, "Short write to device, expected %d, got %d\n", length+1, count);
-        close(fd);
-        return(FALSE);
-    }
-    close(fd);
-    return TRUE;
+    return getBus().write(devAddr, buf, length*2+1);
 }
 
 /** Default timeout value for read operations.
@@ -425,3 +350,111 @@ bool I2Cdev::writeWords(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint16
  */
 uint16_t I2Cdev::readTimeout = 0;
 
+
+/** Bus shared by all the I2Cdev devices.
+ */
+I2CBus& I2Cdev::getBus() {
+    static I2CBus bus;
+    return bus;
+}
+
+/** Bus constructor (the device is opened on the first transaction).
+ * @param device I2C device file
+ */
+I2CBus::I2CBus(const char *device) {
+    this->device = device;
+    fd = -1;
+    slave = -1;
+}
+
+I2CBus::~I2CBus() {
+    reset();
+}
+
+/** Open the bus and select the slave device, if needed.
+ * @param devAddr I2C slave device address
+ * @return File descriptor of the bus (-1 indicates failure)
+ */
+int I2CBus::select(uint8_t devAddr) {
+    if (fd < 0) {
+        fd = open(device, O_RDWR);
+        if (fd < 0) {
+            fprintf(stderr, "Failed to open device: %s\n", strerror(errno));
+            return(-1);
+        }
+        slave = -1;
+    }
+    if (slave != devAddr) {
+        if (ioctl(fd, I2C_SLAVE, devAddr) < 0) {
+            fprintf(stderr, "Failed to select device: %s\n", strerror(errno));
+            return(-1);
+        }
+        slave = devAddr;
+    }
+    return fd;
+}
+
+/** Close the bus, which is opened again by the next transaction.
+ */
+void I2CBus::reset() {
+    if (fd >= 0)
+        close(fd);
+    fd = -1;
+    slave = -1;
+}
+
+/** Read multiple bytes from an 8-bit device register.
+ * @param devAddr I2C slave device address
+ * @param regAddr First register regAddr to read from
+ * @param length Number of bytes to read
+ * @param data Buffer to store read data in
+ * @return Number of bytes read (-1 indicates failure)
+ */
+int I2CBus::readBytes(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t *data) {
+    std::lock_guard<std::mutex> lock(mt);
+    ssize_t count = 0;
+
+    if (select(devAddr) < 0)
+        return(-1);
+    if (::write(fd, &regAddr, 1) != 1) {
+        fprintf(stderr, "Failed to write reg: %s\n", strerror(errno));
+        reset();
+        return(-1);
+    }
+    count = read(fd, data, length);
+    if (count < 0) {
+        fprintf(stderr, "Failed to read device(%d): %s\n", (int)count, ::strerror(errno));
+        reset();
+        return(-1);
+    } else if (count != length) {
+        fprintf(stderr, "Short read  from device, expected %d, got %d\n", length, (int)count);
+        return(-1);
+    }
+
+    return (int)count;
+}
+
+/** Write a buffer (register address and data) to a device.
+ * @param devAddr I2C slave device address
+ * @param buf Register address followed by the data
+ * @param length Number of bytes to write
+ * @return Status of operation (true = success)
+ */
+bool I2CBus::write(uint8_t devAddr, const uint8_t *buf, uint8_t length) {
+    std::lock_guard<std::mutex> lock(mt);
+    ssize_t count = 0;
+
+    if (select(devAddr) < 0)
+        return(FALSE);
+    count = ::write(fd, buf, length);
+    if (count < 0) {
+        fprintf(stderr, "Failed to write device(%d): %s\n", (int)count, ::strerror(errno));
+        reset();
+        return(FALSE);
+    } else if (count != length) {
+        fprintf(stderr, "Short write to device, expected %d, got %d\n", length, (int)count);
+        return(FALSE);
+    }
+
+    return TRUE;
+}
@@ -44,11 +44,37 @@ THE SOFTWARE.
 #ifndef _I2CDEV_H_
 #define _I2CDEV_H_
 
+#include <stdint.h>
+#include <mutex>
+
 #ifndef TRUE
 #define TRUE	(1==1)
 #define FALSE	(0==1)
 #endif
 
+#define I2CDEV_DEFAULT_BUS "/dev/i2c-1"
+
+/** I2C bus with a persistent file descriptor.
+ * The device is opened on the first transaction and the slave address is
+ * only selected again when it changes, so a register access costs the
+ * write and the read calls alone. Transactions are serialized by a mutex.
+ */
+class I2CBus {
+    private:
+        const char *device;
+        int fd;
+        int slave;                  // Selected slave address (-1 = none)
+        std::mutex mt;
+        int select(uint8_t devAddr);
+        void reset();
+    public:
+        I2CBus(const char *device=I2CDEV_DEFAULT_BUS);
+        ~I2CBus();
+
+        int readBytes(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t *data);
+        bool write(uint8_t devAddr, const uint8_t *buf, uint8_t length);
+};
+
 class I2Cdev {
     public:
         I2Cdev();
@@ -59,7 +85,7 @@ class I2Cdev {
         static int8_t readBitsW(uint8_t devAddr, uint8_t regAddr, uint8_t bitStart, uint8_t length, uint16_t *data, uint16_t timeout=I2Cdev::readTimeout);
         static int8_t readByte(uint8_t devAddr, uint8_t regAddr, uint8_t *data, uint16_t timeout=I2Cdev::readTimeout);
         static int8_t readWord(uint8_t devAddr, uint8_t regAddr, uint16_t *data, uint16_t timeout=I2Cdev::readTimeout);
-        static int8_t readBytes(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t *data, uint16_t timeout=I2Cdev::readTimeout);
+        static int readBytes(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint8_t *data, uint16_t timeout=I2Cdev::readTimeout);
         static int8_t readWords(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint16_t *data, uint16_t timeout=I2Cdev::readTimeout);
 
         static bool writeBit(uint8_t devAddr, uint8_t regAddr, uint8_t bitNum, uint8_t data);
@@ -72,6 +98,8 @@ class I2Cdev {
         static bool writeWords(uint8_t devAddr, uint8_t regAddr, uint8_t length, uint16_t *data);
 
         static uint16_t readTimeout;
+
+        static I2CBus& getBus();
 };
 
 #endif /* _I2CDEV_H_ */
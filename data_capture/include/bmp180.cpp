@@ -33,6 +33,8 @@ BMP180::BMP180(unsigned int o, int rpi_version)
 	else
 		oss = o;
 	
+	state = BMP180_IDLE;
+	
 	if ((fd = I2C_Setup(BMP180_ADR, rpi_version)) < 0)
         throw std::runtime_error("Failed to open I2C bus!");
     else
@@ -51,80 +53,126 @@ BMP180::~BMP180()
 // Calibration data reading
 void BMP180::LoadCalibration()
 {
-	cal_reg.ac1 = (I2C_ReadReg8(fd, AC1_MSB) << 8) + I2C_ReadReg8(fd, AC1_LSB);
-	cal_reg.ac2 = (I2C_ReadReg8(fd, AC2_MSB) << 8) + I2C_ReadReg8(fd, AC2_LSB);
-	cal_reg.ac3 = (I2C_ReadReg8(fd, AC3_MSB) << 8) + I2C_ReadReg8(fd, AC3_LSB);
-	cal_reg.ac4 = (I2C_ReadReg8(fd, AC4_MSB) << 8) + I2C_ReadReg8(fd, AC4_LSB);
-	cal_reg.ac5 = (I2C_ReadReg8(fd, AC5_MSB) << 8) + I2C_ReadReg8(fd, AC5_LSB);
-	cal_reg.ac6 = (I2C_ReadReg8(fd, AC6_MSB) << 8) + I2C_ReadReg8(fd, AC6_LSB);
-	cal_reg.b1 = (I2C_ReadReg8(fd, B1_MSB) << 8) + I2C_ReadReg8(fd, B1_LSB);
-	cal_reg.b2 = (I2C_ReadReg8(fd, B2_MSB) << 8) + I2C_ReadReg8(fd, B2_LSB);
-	cal_reg.mb = (I2C_ReadReg8(fd, MB_MSB) << 8) + I2C_ReadReg8(fd, MB_LSB);
-	cal_reg.mc = (I2C_ReadReg8(fd, MC_MSB) << 8) + I2C_ReadReg8(fd, MC_LSB);
-	cal_reg.md = (I2C_ReadReg8(fd, MD_MSB) << 8) + I2C_ReadReg8(fd, MD_LSB);
+	uint8_t data[MD_LSB - AC1_MSB + 1];									// 11 words, MSB first
+	
+	if (I2C_ReadBlock(fd, AC1_MSB, data, sizeof(data)) < 0)
+		throw std::runtime_error("Error reading from the device!");
+	
+	cal_reg.ac1 = (data[AC1_MSB - AC1_MSB] << 8) + data[AC1_LSB - AC1_MSB];
+	cal_reg.ac2 = (data[AC2_MSB - AC1_MSB] << 8) + data[AC2_LSB - AC1_MSB];
+	cal_reg.ac3 = (data[AC3_MSB - AC1_MSB] << 8) + data[AC3_LSB - AC1_MSB];
+	cal_reg.ac4 = (data[AC4_MSB - AC1_MSB] << 8) + data[AC4_LSB - AC1_MSB];
+	cal_reg.ac5 = (data[AC5_MSB - AC1_MSB] << 8) + data[AC5_LSB - AC1_MSB];
+	cal_reg.ac6 = (data[AC6_MSB - AC1_MSB] << 8) + data[AC6_LSB - AC1_MSB];
+	cal_reg.b1 = (data[B1_MSB - AC1_MSB] << 8) + data[B1_LSB - AC1_MSB];
+	cal_reg.b2 = (data[B2_MSB - AC1_MSB] << 8) + data[B2_LSB - AC1_MSB];
+	cal_reg.mb = (data[MB_MSB - AC1_MSB] << 8) + data[MB_LSB - AC1_MSB];
+	cal_reg.mc = (data[MC_MSB - AC1_MSB] << 8) + data[MC_LSB - AC1_MSB];
+	cal_reg.md = (data[MD_MSB - AC1_MSB] << 8) + data[MD_LSB - AC1_MSB];
 }
 
-// Read uncompensated temperature value
-int32_t BMP180::getUT()
+// Conversion time (us) of a command
+unsigned int BMP180::getConversionTime(uint8_t command)
 {
-	if (I2C_WriteReg8(fd, BMP180_REG_CONTROL, BMP180_COMMAND_TEMPERATURE) < 0)
+	if (command == BMP180_COMMAND_TEMPERATURE)
+		return 5000;
+	
+	switch(oss)
 	{
-		throw std::runtime_error("Error writing into the device!");
-		
-		return -1;
+		case BMP180_ULTRALOWPOWER:
+			return 5000;
+		case BMP180_STANDARD:
+			return 8000;
+		case BMP180_HIGHRES:
+			return 14000;
+		case BMP180_ULTRAHIGHRES:
+			return 26000;
+		default:
+			return 8000;
 	}
+}
+
+void BMP180::StartConversion(uint8_t command)
+{
+	if (command == BMP180_COMMAND_PRESSURE)
+		command += oss << 6;
+	
+	if (I2C_WriteReg8(fd, BMP180_REG_CONTROL, command) < 0)
+		throw std::runtime_error("Error writing into the device!");
+	
+	conversion_end = std::chrono::steady_clock::now() + std::chrono::microseconds(this->getConversionTime(command));
+}
+
+// Result of the last conversion (2 bytes for the temperature, 3 for the pressure)
+int32_t BMP180::ReadResult(int length)
+{
+	uint8_t data[3];
+	if (I2C_ReadBlock(fd, BMP180_REG_RESULT, data, length) < 0)
+		throw std::runtime_error("Error reading from the device!");
+	
+	if (length == 2)
+		return (data[0] << 8) + data[1];
 	else
-	{
-		usleep(5000);
-		
-		int32_t UT = (I2C_ReadReg8(fd, BMP180_REG_RESULT) << 8) + I2C_ReadReg8(fd, 0xF7);
-		
-		return UT;
-	}
+		return ((data[0] << 16) + (data[1] << 8) + data[2]) >> (8 - oss);
+}
+
+// Read uncompensated temperature value
+int32_t BMP180::getUT()
+{
+	this->StartConversion(BMP180_COMMAND_TEMPERATURE);
+	usleep(this->getConversionTime(BMP180_COMMAND_TEMPERATURE));
+	
+	return this->ReadResult(2);
 }
 
 // Read uncompensated pressure value
 int32_t BMP180::getUP()
 {
-	if (I2C_WriteReg8(fd, BMP180_REG_CONTROL, BMP180_COMMAND_PRESSURE + (oss << 6)) < 0)
-	{
-		throw std::runtime_error("Error writing into the device!");
-		
-		return -1;
-	}
-	else
-	{
-		switch(oss)
-		{
-			case BMP180_ULTRALOWPOWER:
-				usleep(5000);
-				break;
-			case BMP180_STANDARD:
-				usleep(8000);
-				break;
-			case BMP180_HIGHRES:
-				usleep(14000);
-				break;
-			case BMP180_ULTRAHIGHRES:
-				usleep(26000);
-				break;
-			default:
-				usleep(8000);
-				break;
-		}
-
-		int32_t UP = ((I2C_ReadReg8(fd, BMP180_REG_RESULT) << 16) + (I2C_ReadReg8(fd, 0xF7) << 8) + I2C_ReadReg8(fd, 0xF8)) >> (8 - oss);
-
-		return UP;
-	}
+	this->StartConversion(BMP180_COMMAND_PRESSURE);
+	usleep(this->getConversionTime(BMP180_COMMAND_PRESSURE));
+	
+	return this->ReadResult(3);
 }
 
+// Blocking read of the temperature and the pressure
 void BMP180::Read()
 {
+	state = BMP180_IDLE;												// Any pending conversion is discarded
 	UT = this->getUT();
 	UP = this->getUP();
 }
 
+// Non-blocking read: starts a conversion, or collects the finished one and
+// starts the next, alternating temperature and pressure. Returns true when
+// a new pressure (and so altitude) value is available.
+bool BMP180::Update()
+{
+	if (state == BMP180_IDLE)
+	{
+		this->StartConversion(BMP180_COMMAND_TEMPERATURE);
+		state = BMP180_CONVERTING_TEMPERATURE;
+		return false;
+	}
+	
+	if (std::chrono::steady_clock::now() < conversion_end)
+		return false;
+	
+	if (state == BMP180_CONVERTING_TEMPERATURE)
+	{
+		UT = this->ReadResult(2);
+		this->StartConversion(BMP180_COMMAND_PRESSURE);
+		state = BMP180_CONVERTING_PRESSURE;
+		return false;
+	}
+	else
+	{
+		UP = this->ReadResult(3);
+		this->StartConversion(BMP180_COMMAND_TEMPERATURE);
+		state = BMP180_CONVERTING_TEMPERATURE;
+		return true;
+	}
+}
+
 // Calculate true temperature
 double BMP180::getTemperature()
 {
@@ -23,6 +23,7 @@
 #define BMP180_H_
 
 #include <stdint.h>
+#include <chrono>
 
 #define BMP180_ADR 0x77
 
@@ -63,6 +64,11 @@
 #define MC_LSB 0xBD
 #define MD_LSB 0xBF
 
+// Conversion states (see BMP180::Update())
+#define BMP180_IDLE 0
+#define BMP180_CONVERTING_TEMPERATURE 1
+#define BMP180_CONVERTING_PRESSURE 2
+
 // Sealevel pressure
 #define  SEALEVEL_PRESSURE 101325
 
@@ -87,14 +93,20 @@ class BMP180 {
 		int32_t P0;
 		int32_t UT;
 		int32_t UP;
+		int state;
+		std::chrono::steady_clock::time_point conversion_end;
 		void LoadCalibration();
 		void LoadDatasheetCalibration();
+		void StartConversion(uint8_t);
+		int32_t ReadResult(int);
+		unsigned int getConversionTime(uint8_t);
 	public:
 		BMP180(unsigned int o=BMP180_STANDARD, int rpi_version=2);
 		~BMP180();
 		int32_t getUT();
 		int32_t getUP();
 		void Read();
+		bool Update();
 		double getTemperature();
 		int32_t getPressure();
 		double getAltitude();
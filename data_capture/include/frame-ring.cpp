@@ -0,0 +1,214 @@
+/*
+ * Traffic Management UAV Data Capture.
+ * A program to capture images and sensors data with Raspberry Pi.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#include <cstddef>
+#include <cerrno>
+#include <stdexcept>
+#include <stdint.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+
+#include "frame-ring.h"
+
+// The indexes grow modulo 2^32 and wrap around the rings with %, so the
+// sizes must be powers of two. The released ring holds at most size+1
+// buffers, it is 2*size long.
+FrameRing::FrameRing(unsigned int size, int p)
+	: buffers(size + 2), queued(size), released(2*size)
+{
+	if ((size == 0) or ((size & (size - 1)) != 0))
+		throw std::runtime_error("The frame ring size must be a power of two!");
+	
+	policy = p;
+	head = tail = 0;
+	released_head = released_tail = 0;
+	captured = dropped = recorded = 0;
+	sleeping = false;
+	
+	event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (event_fd < 0)
+		throw std::runtime_error("It is not possible to create the frame ring event!");
+	
+	// Buffer 0 is the camera one, the others start free
+	writing = 0;
+	reading = -1;
+	for(unsigned int i=1;i<buffers.size();i++)
+		released[released_tail++ % released.size()].store(i, std::memory_order_relaxed);
+}
+
+FrameRing::~FrameRing()
+{
+	close(event_fd);
+}
+
+// Recorder side: oldest queued buffer (-1 if empty). The camera also moves
+// the head when it drops the oldest frame. The indexes only grow (modulo
+// 2^32), so a late compare and swap can not succeed by mistake.
+int FrameRing::PopQueued()
+{
+	unsigned int h = head.load(std::memory_order_acquire);
+	while(h != tail.load(std::memory_order_acquire))
+	{
+		int b = queued[h % queued.size()].load(std::memory_order_relaxed);
+		if (head.compare_exchange_weak(h, h + 1, std::memory_order_acq_rel))
+			return b;
+	}
+	
+	return -1;
+}
+
+int FrameRing::PopReleased()
+{
+	unsigned int h = released_head.load(std::memory_order_relaxed);
+	if (h == released_tail.load(std::memory_order_acquire))
+		return -1;
+	
+	int b = released[h % released.size()].load(std::memory_order_relaxed);
+	released_head.store(h + 1, std::memory_order_release);
+	
+	return b;
+}
+
+// Camera side: buffer for the next frame
+Frame* FrameRing::getWriteFrame()
+{
+	return &buffers[writing];
+}
+
+// Camera side: queue the frame written in getWriteFrame()
+void FrameRing::Publish()
+{
+	captured.fetch_add(1, std::memory_order_relaxed);
+	
+	unsigned int t = tail.load(std::memory_order_relaxed);
+	int free_buffer = -1;
+	if (t - head.load(std::memory_order_acquire) == queued.size())
+	{
+		if (policy == FRAME_RING_DROP_NEWEST)
+		{
+			dropped.fetch_add(1, std::memory_order_relaxed);			// The buffer is written again
+			return;
+		}
+		
+		// The oldest buffer becomes the new camera buffer, unless the
+		// recorder has just taken it: then there is room, and nothing else
+		// is dropped
+		unsigned int h = head.load(std::memory_order_acquire);
+		if (t - h == queued.size())
+		{
+			int b = queued[h % queued.size()].load(std::memory_order_relaxed);
+			if (head.compare_exchange_strong(h, h + 1, std::memory_order_acq_rel))
+			{
+				free_buffer = b;
+				dropped.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+	}
+	
+	queued[t % queued.size()].store(writing, std::memory_order_relaxed);
+	tail.store(t + 1, std::memory_order_release);
+	
+	// With size+2 buffers there is always a free one after a push
+	writing = (free_buffer >= 0)? free_buffer:this->PopReleased();
+	
+	// Pairs with the fence in Wait(): either the recorder sees the new
+	// frame before sleeping, or the camera sees it sleeping
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (sleeping.load(std::memory_order_relaxed) and sleeping.exchange(false))
+	{
+		uint64_t one = 1;
+		ssize_t r = write(event_fd, &one, sizeof(one));
+		(void)r;														// A full counter already wakes the recorder
+	}
+}
+
+// Recorder side: oldest frame, or NULL if there is none
+Frame* FrameRing::Front()
+{
+	if (reading < 0)
+		reading = this->PopQueued();
+	
+	return (reading < 0)? NULL:&buffers[reading];
+}
+
+// Recorder side: the frame returned by Front() was recorded
+void FrameRing::Release()
+{
+	if (reading < 0)
+		return;
+	
+	unsigned int t = released_tail.load(std::memory_order_relaxed);
+	released[t % released.size()].store(reading, std::memory_order_relaxed);
+	released_tail.store(t + 1, std::memory_order_release);
+	reading = -1;
+	
+	recorded.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Recorder side: sleep until there is a frame to record or the timeout (ms)
+// expires. Returns true if there is a frame.
+bool FrameRing::Wait(int timeout)
+{
+	if (reading >= 0)
+		return true;
+	
+	sleeping.store(true, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	
+	if (head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire))
+	{
+		struct pollfd pfd;
+		pfd.fd = event_fd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		
+		while((poll(&pfd, 1, timeout) < 0) and (errno == EINTR))
+			;
+	}
+	
+	sleeping.store(false, std::memory_order_relaxed);
+	
+	uint64_t events;
+	ssize_t r = read(event_fd, &events, sizeof(events));				// Clears the event (EAGAIN if there is none)
+	(void)r;
+	
+	return head.load(std::memory_order_acquire) != tail.load(std::memory_order_acquire);
+}
+
+unsigned int FrameRing::getSize()
+{
+	return queued.size();
+}
+unsigned long FrameRing::getCaptured()
+{
+	return captured.load(std::memory_order_relaxed);
+}
+
+unsigned long FrameRing::getDropped()
+{
+	return dropped.load(std::memory_order_relaxed);
+}
+
+unsigned long FrameRing::getRecorded()
+{
+	return recorded.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,88 @@
+/*
+ * Traffic Management UAV Data Capture.
+ * A program to capture images and sensors data with Raspberry Pi.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#ifndef FRAME_RING_H_
+#define FRAME_RING_H_
+
+#include <vector>
+#include <atomic>
+#include <opencv2/opencv.hpp>
+
+#include "sensor-hub.h"
+
+// Overflow policies, when the recording can not keep up with the camera
+#define FRAME_RING_DROP_OLDEST 0										// Keep the most recent frames
+#define FRAME_RING_DROP_NEWEST 1										// Keep the frames already queued
+
+struct Frame {
+	cv::Mat frame;
+	unsigned int n;
+	unsigned int time;													// Capture time (ms since the start)
+	uint64_t clock;														// Capture time (CLOCK_MONOTONIC, ns)
+	SensorSnapshot sensors;												// Latest sensors data at the capture
+};
+
+/*
+ * Single producer/single consumer ring of reusable frame buffers.
+ * 
+ * The ring holds the indexes of size+2 preallocated buffers: the camera
+ * writes in its own buffer and the recorder reads its own, so neither of
+ * them waits for the other. The used buffers go back to the camera by a
+ * free list. When the ring is full the camera drops a frame, according to
+ * the policy, and never blocks. The size must be a power of two.
+ * 
+ * An idle recorder sleeps in Wait() on an eventfd. The camera only signals
+ * it when it is sleeping, so a busy recorder drains the frames in batches
+ * without any system call.
+ */
+class FrameRing {
+		std::vector<Frame> buffers;
+		int policy;
+		std::vector<std::atomic<int> > queued;							// Frames waiting to be recorded (buffer indexes)
+		std::atomic<unsigned int> head;									// Next frame to record (also moved by the drops)
+		std::atomic<unsigned int> tail;									// Next free slot
+		std::vector<std::atomic<int> > released;						// Recorded buffers, back to the camera
+		std::atomic<unsigned int> released_head;
+		std::atomic<unsigned int> released_tail;
+		int writing;													// Camera buffer
+		int reading;													// Recorder buffer (-1 = none)
+		std::atomic<unsigned long> captured;
+		std::atomic<unsigned long> dropped;
+		std::atomic<unsigned long> recorded;
+		int event_fd;													// Wakes the recorder
+		std::atomic<bool> sleeping;
+		int PopQueued();
+		int PopReleased();
+	public:
+		FrameRing(unsigned int size, int p=FRAME_RING_DROP_OLDEST);
+		~FrameRing();
+		Frame* getWriteFrame();
+		void Publish();
+		Frame* Front();
+		void Release();
+		bool Wait(int timeout=-1);
+		unsigned int getSize();
+		unsigned long getCaptured();
+		unsigned long getDropped();
+		unsigned long getRecorded();
+};
+
+#endif
@@ -104,17 +104,16 @@ void HMC5883::setDeclinationAngle(double angle)
 
 void HMC5883::Read()
 {	
-	int8_t x_msb = I2C_ReadReg8(fd, HMC5883_X_MSB);
-	int8_t x_lsb = I2C_ReadReg8(fd, HMC5883_X_LSB);
-	int8_t z_msb = I2C_ReadReg8(fd, HMC5883_Z_MSB);
-	int8_t z_lsb = I2C_ReadReg8(fd, HMC5883_Z_LSB);
-	int8_t y_msb = I2C_ReadReg8(fd, HMC5883_Y_MSB);
-	int8_t y_lsb = I2C_ReadReg8(fd, HMC5883_Y_LSB);
+	uint8_t data[6];													// X, Z and Y, MSB first
+	
+	// One transaction, so the three axes belong to the same measurement
+	if (I2C_ReadBlock(fd, HMC5883_X_MSB, data, 6) < 0)
+		throw std::runtime_error("Error reading from the device!");
 
-	// Shift values to create properly formed integer (low byte first)
-	magData.x = int16_t(x_lsb | (int16_t(x_msb) << 8))/hmc5883_Gauss_LSB_XY*100;		// 100: gauss to uT conversion
-	magData.y = int16_t(y_lsb | (int16_t(y_msb) << 8))/hmc5883_Gauss_LSB_XY*100;
-	magData.z = int16_t(z_lsb | (int16_t(z_msb) << 8))/hmc5883_Gauss_LSB_Z*100;
+	// Shift values to create properly formed integer
+	magData.x = int16_t((data[0] << 8) | data[1])/hmc5883_Gauss_LSB_XY*100;		// 100: gauss to uT conversion
+	magData.y = int16_t((data[4] << 8) | data[5])/hmc5883_Gauss_LSB_XY*100;
+	magData.z = int16_t((data[2] << 8) | data[3])/hmc5883_Gauss_LSB_Z*100;
 	magData.orientation = 0.0;											// >>>>>>>>>>>>> ToDo: Calculate orientation
 }
 
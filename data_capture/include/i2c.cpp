@@ -139,6 +139,36 @@ int I2C_ReadReg16(int fd, int reg)
         return data.word & 0xFFFF;
 }
 
+// Reads length consecutive registers, starting at reg, in one transaction
+// for each I2C_SMBUS_I2C_BLOCK_MAX bytes. Returns the number of bytes read
+// or -1 on error.
+int I2C_ReadBlock(int fd, int reg, uint8_t *buf, int length)
+{
+    union i2c_smbus_data data;
+    int count = 0;
+
+    while(count < length)
+    {
+        int n = length - count;
+        if (n > I2C_SMBUS_I2C_BLOCK_MAX)
+            n = I2C_SMBUS_I2C_BLOCK_MAX;
+
+        data.block[0] = n;
+        if (i2c_smbus_access(fd, I2C_SMBUS_READ, reg + count, I2C_SMBUS_I2C_BLOCK_DATA, &data))
+            return -1;
+
+        for(int i=0;i<data.block[0];i++)
+            buf[count + i] = data.block[i + 1];
+
+        if (data.block[0] != n)                                         // Short read
+            return -1;
+
+        count += n;
+    }
+
+    return count;
+}
+
 //**********************************************************************
 // -- WRITE ------------------------------------------------------------
 //**********************************************************************
@@ -28,11 +28,14 @@
 #ifndef I2C_H_
 #define I2C_H_
 
+#include <stdint.h>
+
 int I2C_Setup(const int, int);
 
 int I2C_Read(int);
 int I2C_ReadReg8(int, int);
 int I2C_ReadReg16(int, int);
+int I2C_ReadBlock(int, int, uint8_t*, int);
 
 int I2C_Writed(int, int);
 int I2C_WriteReg8(int, int, int);
@@ -0,0 +1,136 @@
+/*
+ * Traffic Management UAV Data Capture.
+ * A program to capture images and sensors data with Raspberry Pi.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#include "imu-stream.h"
+
+IMUStream::IMUStream(unsigned int size)
+	: slots(size)
+{
+	count.store(0);
+	overflows.store(0);
+	last_time = 0;
+}
+
+IMUStream::~IMUStream()
+{
+	
+}
+
+// The times are estimated from the read time, so they are forced to grow
+void IMUStream::Push(const IMUSample &sample)
+{
+	unsigned long n = count.load(std::memory_order_relaxed);
+	IMUSlot slot;
+	
+	slot.sample = sample;
+	slot.n = n;
+	if ((n > 0) and (slot.sample.time <= last_time))
+		slot.sample.time = last_time + 1;
+	last_time = slot.sample.time;
+	
+	slots[n % slots.size()].Store(slot);
+	count.store(n + 1, std::memory_order_release);						// The slot is written before it is counted
+}
+
+void IMUStream::AddOverflow()
+{
+	overflows.fetch_add(1, std::memory_order_relaxed);
+}
+
+unsigned long IMUStream::getCount() const
+{
+	return count.load(std::memory_order_acquire);
+}
+
+unsigned long IMUStream::getOverflows() const
+{
+	return overflows.load(std::memory_order_relaxed);
+}
+
+// Sample number n, if its slot was not overwritten by a newer one
+bool IMUStream::getSlot(unsigned long n, IMUSample *sample) const
+{
+	IMUSlot slot = slots[n % slots.size()].Load();
+	
+	if (slot.n != n)
+		return false;
+	
+	*sample = slot.sample;
+	
+	return true;
+}
+
+// Sample number n (counted since the start), if it is still kept
+bool IMUStream::getSample(unsigned long n, IMUSample *sample) const
+{
+	if (n >= this->getCount())
+		return false;
+	
+	return this->getSlot(n, sample);
+}
+
+bool IMUStream::getLatest(IMUSample *sample) const
+{
+	unsigned long c = this->getCount();
+	
+	if (c == 0)
+		return false;
+	
+	return this->getSlot(c - 1, sample);
+}
+
+// Kept sample nearest to a time (CLOCK_MONOTONIC, ns)
+bool IMUStream::getSampleAt(uint64_t time, IMUSample *sample) const
+{
+	unsigned long c = this->getCount();
+	
+	if (c == 0)
+		return false;
+	
+	// Binary search of the first sample at or after the time. A slot
+	// overwritten during the search holds a newer sample, so everything up
+	// to it is gone and the search goes on after it.
+	unsigned long lo = (c > slots.size())? c - slots.size():0;
+	unsigned long hi = c;
+	IMUSample s;
+	while(lo < hi)
+	{
+		unsigned long mid = (lo + hi)/2;
+		if (!this->getSlot(mid, &s) or (s.time < time))
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	
+	// Nearest of the samples before and after the time
+	IMUSample before, after;
+	bool has_before = (lo > 0) and this->getSlot(lo - 1, &before);
+	bool has_after = (lo < c) and this->getSlot(lo, &after);
+	
+	if (has_before and (!has_after or (time - before.time < after.time - time)))
+		*sample = before;
+	else if (has_after)
+		*sample = after;
+	else
+		return false;
+	
+	return true;
+}
@@ -0,0 +1,76 @@
+/*
+ * Traffic Management UAV Data Capture.
+ * A program to capture images and sensors data with Raspberry Pi.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#ifndef IMU_STREAM_H_
+#define IMU_STREAM_H_
+
+#include <vector>
+#include <atomic>
+#include <stdint.h>
+
+#include "seqlock.h"
+
+#define IMU_STREAM_SIZE 256												// 2.56 s of DMP packets at 100 Hz
+
+// One DMP packet
+struct IMUSample {
+	uint64_t time;														// CLOCK_MONOTONIC, ns
+	int16_t accel[3];
+	int16_t gyro[3];
+	float q[4];															// w, x, y, z
+	float euler[3];														// psi, theta, phi (rad)
+	float ypr[3];														// yaw, pitch, roll (deg)
+};
+
+// A sample and its number, to detect the slots already overwritten
+struct IMUSlot {
+	IMUSample sample;
+	unsigned long n;
+};
+
+/*
+ * Full rate IMU samples.
+ * 
+ * Keeps the last samples read from the DMP FIFO, in order, so consumers can
+ * get every sample since the last one they saw, or the attitude at a given
+ * time (e.g. the capture time of a frame). The thread that reads the IMU is
+ * the only writer; any thread can read. Each slot is a seqlock, so the
+ * readers never block the writer and never get a torn sample.
+ */
+class IMUStream {
+		std::vector<Seqlock<IMUSlot> > slots;
+		std::atomic<unsigned long> count;								// Samples pushed since the start
+		std::atomic<unsigned long> overflows;							// FIFO overflows (samples lost)
+		uint64_t last_time;												// Writer only
+		bool getSlot(unsigned long, IMUSample*) const;
+	public:
+		IMUStream(unsigned int size=IMU_STREAM_SIZE);
+		~IMUStream();
+		void Push(const IMUSample&);
+		void AddOverflow();
+		unsigned long getCount() const;
+		unsigned long getOverflows() const;
+		bool getSample(unsigned long, IMUSample*) const;
+		bool getLatest(IMUSample*) const;
+		bool getSampleAt(uint64_t, IMUSample*) const;
+};
+
+#endif
@@ -0,0 +1,258 @@
+/*
+ * Traffic Management UAV Data Capture.
+ * A program to capture images and sensors data with Raspberry Pi.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <chrono>
+#include <stdexcept>
+#include <unistd.h>
+
+#include "jpeg-pool.h"
+#include "scheduler.h"													// MonotonicTime()
+
+#define JOB_FREE 0
+#define JOB_QUEUED 1
+#define JOB_ENCODING 2
+#define JOB_ENCODED 3
+
+JpegPool::JpegPool(std::string f, const IMUStream *i, unsigned int n, int quality, bool optimize, bool progressive)
+	: jobs(2*n)
+{
+	if (n == 0)
+		throw std::runtime_error("The JPEG pool needs at least one worker!");
+	
+	folder = f;
+	imu = i;
+	
+	telemetry.open((folder + "telemetry.csv").c_str());
+	if (!telemetry)
+		throw std::runtime_error("Error opening the telemetry file!");
+	telemetry << "frame,time,latitude,longitude,gps_altitude,altitude,speed,course,"
+			  << "yaw,pitch,roll,qw,qx,qy,qz,heading,sensors_age_ms,imu_offset_ms" << std::endl;
+	
+	params.push_back(cv::IMWRITE_JPEG_QUALITY);
+	params.push_back(quality);
+	params.push_back(cv::IMWRITE_JPEG_OPTIMIZE);
+	params.push_back(optimize);
+	params.push_back(cv::IMWRITE_JPEG_PROGRESSIVE);
+	params.push_back(progressive);
+	
+	for(unsigned int i=0;i<jobs.size();i++)
+		jobs[i].state = JOB_FREE;
+	
+	submitted = encoding = written = 0;
+	writing = false;
+	stop = false;
+	encoded = 0;
+	encode_time = max_encode_time = 0;
+	max_depth = 0;
+	
+	for(unsigned int i=0;i<n;i++)
+		workers.push_back(std::thread(&JpegPool::Work, this));
+}
+
+// Encodes the queued frames and writes them before returning
+JpegPool::~JpegPool()
+{
+	{
+		std::unique_lock<std::mutex> lock(mt);
+		stop = true;
+	}
+	job_ready.notify_all();
+	
+	for(unsigned int i=0;i<workers.size();i++)
+		workers[i].join();
+}
+
+void JpegPool::Submit(Frame *fr)
+{
+	std::unique_lock<std::mutex> lock(mt);
+	
+	JpegJob &job = jobs[submitted % jobs.size()];
+	while(job.state != JOB_FREE)
+		job_free.wait(lock);
+	
+	// The ring buffer keeps the previous image of the job, which the camera
+	// overwrites without allocating once the sizes match
+	cv::swap(job.frame, fr->frame);
+	job.n = fr->n;
+	job.time = fr->time;
+	job.clock = fr->clock;
+	job.sensors = fr->sensors;
+	job.state = JOB_QUEUED;
+	submitted++;
+	
+	if (submitted - written > max_depth)
+		max_depth = submitted - written;
+	
+	lock.unlock();
+	job_ready.notify_one();
+}
+
+void JpegPool::Work()
+{
+	std::unique_lock<std::mutex> lock(mt);
+	
+	while(true)
+	{
+		while(!stop and (encoding == submitted))
+			job_ready.wait(lock);
+		
+		if (encoding == submitted)
+			break;
+		
+		JpegJob &job = jobs[encoding++ % jobs.size()];
+		job.state = JOB_ENCODING;
+		std::vector<int> p = params;
+		lock.unlock();
+		
+		auto encode_start = std::chrono::high_resolution_clock::now();
+		cv::imencode(".jpg", job.frame, job.data, p);
+		auto encode_end = std::chrono::high_resolution_clock::now();
+		double t = std::chrono::duration<double, std::milli>(encode_end - encode_start).count();
+		
+		lock.lock();
+		job.state = JOB_ENCODED;
+		encoded++;
+		encode_time += t;
+		if (t > max_encode_time)
+			max_encode_time = t;
+		
+		if (!writing)
+			this->WriteFiles(lock);
+	}
+}
+
+// Writes the encoded jobs that follow the last written one (called with
+// the lock held, which is released while writing)
+void JpegPool::WriteFiles(std::unique_lock<std::mutex> &lock)
+{
+	writing = true;
+	
+	while(written != submitted)
+	{
+		JpegJob &job = jobs[written % jobs.size()];
+		if (job.state != JOB_ENCODED)
+			break;
+		lock.unlock();
+		
+		char file_name[16];
+		snprintf(file_name, sizeof(file_name), "%06u.jpg", job.n);
+		
+		std::ofstream fout((folder + file_name).c_str(), std::ios::binary);
+		fout.write((const char*)job.data.data(), job.data.size());
+		
+		const SensorsData &d = job.sensors.data;
+		IMUSample s;
+		bool attitude = this->getAttitude(job.clock, &s);
+		if (!attitude)
+		{
+			// The newest attitude of the sensors data
+			s.time = job.clock;
+			s.ypr[0] = d.yaw;
+			s.ypr[1] = d.pitch;
+			s.ypr[2] = d.roll;
+			s.q[0] = d.qw;
+			s.q[1] = d.qx;
+			s.q[2] = d.qy;
+			s.q[3] = d.qz;
+		}
+		
+		telemetry << job.n << "," << job.time << ","
+				  << d.latitude << "," << d.longitude << "," << d.gps_altitude << "," << d.altitude << ","
+				  << d.speed << "," << d.course << ","
+				  << s.ypr[0] << "," << s.ypr[1] << "," << s.ypr[2] << ","
+				  << s.q[0] << "," << s.q[1] << "," << s.q[2] << "," << s.q[3] << "," << d.heading << ","
+				  << ((job.sensors.n > 0)? (job.clock - job.sensors.time)/1e6:-1) << ",";
+		if (attitude)
+			telemetry << (int64_t(s.time) - int64_t(job.clock))/1e6;
+		telemetry << "\n";
+		
+		lock.lock();
+		job.state = JOB_FREE;
+		written++;
+		job_free.notify_one();
+	}
+	
+	writing = false;
+}
+
+// IMU sample nearest to a capture time. The IMU is read in bursts, so the
+// samples that follow the capture may still be in the DMP FIFO: they are
+// waited for until JPEG_POOL_IMU_WAIT ms after the capture.
+bool JpegPool::getAttitude(uint64_t clock, IMUSample *sample)
+{
+	if (imu == NULL)
+		return false;
+	
+	IMUSample latest;
+	while(!imu->getLatest(&latest) or (latest.time < clock))
+	{
+		if (MonotonicTime() - clock >= uint64_t(JPEG_POOL_IMU_WAIT)*1000000)
+			break;
+		usleep(1000);
+	}
+	
+	return imu->getSampleAt(clock, sample);
+}
+
+void JpegPool::setParams(std::vector<int> p)
+{
+	std::unique_lock<std::mutex> lock(mt);
+	params = p;
+}
+
+unsigned int JpegPool::getWorkers()
+{
+	return workers.size();
+}
+
+// Frames submitted and not written yet
+unsigned int JpegPool::getQueueDepth()
+{
+	std::unique_lock<std::mutex> lock(mt);
+	return submitted - written;
+}
+
+unsigned int JpegPool::getMaxQueueDepth()
+{
+	std::unique_lock<std::mutex> lock(mt);
+	return max_depth;
+}
+
+unsigned long JpegPool::getEncoded()
+{
+	std::unique_lock<std::mutex> lock(mt);
+	return encoded;
+}
+
+// Average encoding time (ms)
+double JpegPool::getEncodeTime()
+{
+	std::unique_lock<std::mutex> lock(mt);
+	return (encoded > 0)? encode_time/encoded:0;
+}
+
+double JpegPool::getMaxEncodeTime()
+{
+	std::unique_lock<std::mutex> lock(mt);
+	return max_encode_time;
+}
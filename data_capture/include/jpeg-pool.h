@@ -0,0 +1,97 @@
+/*
+ * Traffic Management UAV Data Capture.
+ * A program to capture images and sensors data with Raspberry Pi.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#ifndef JPEG_POOL_H_
+#define JPEG_POOL_H_
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <opencv2/opencv.hpp>
+
+#include "frame-ring.h"
+#include "imu-stream.h"
+
+#define JPEG_POOL_WORKERS 3												// Parallel encoders (the Pi 3 has 4 cores)
+#define JPEG_POOL_QUALITY 95											// OpenCV default
+#define JPEG_POOL_IMU_WAIT 100											// ms after the capture, for the IMU samples to be read
+
+struct JpegJob {
+	cv::Mat frame;
+	unsigned int n;
+	unsigned int time;
+	uint64_t clock;
+	SensorSnapshot sensors;
+	std::vector<uchar> data;											// Encoded image
+	int state;
+};
+
+/*
+ * Pool of JPEG encoder threads.
+ * 
+ * Submit() takes the image of a frame of the ring (the Mat buffers are
+ * swapped, not copied) and a worker encodes it. The files are written in
+ * the order of the frames, by the worker that completes the sequence.
+ * Submit() waits when all the jobs are busy, so the frame ring drops the
+ * frames that can not be encoded in time. The sensors data of each frame is
+ * written, also in order, to telemetry.csv, with the attitude of the IMU
+ * sample nearest to the capture time when an IMU stream is given.
+ */
+class JpegPool {
+		std::string folder;
+		std::ofstream telemetry;
+		const IMUStream *imu;
+		std::vector<int> params;										// cv::imencode parameters
+		std::vector<JpegJob> jobs;
+		std::vector<std::thread> workers;
+		std::mutex mt;
+		std::condition_variable job_ready;
+		std::condition_variable job_free;
+		unsigned long submitted;										// Jobs are used in this order
+		unsigned long encoding;											// Next job to encode
+		unsigned long written;											// Next job to write
+		bool writing;
+		bool stop;
+		unsigned long encoded;
+		double encode_time;												// Total, in ms
+		double max_encode_time;
+		unsigned int max_depth;
+		void Work();
+		void WriteFiles(std::unique_lock<std::mutex>&);
+		bool getAttitude(uint64_t, IMUSample*);
+	public:
+		JpegPool(std::string, const IMUStream *i=NULL, unsigned int n=JPEG_POOL_WORKERS, int quality=JPEG_POOL_QUALITY,
+				 bool optimize=false, bool progressive=false);
+		~JpegPool();
+		void Submit(Frame*);
+		void setParams(std::vector<int>);
+		unsigned int getWorkers();
+		unsigned int getQueueDepth();
+		unsigned int getMaxQueueDepth();
+		unsigned long getEncoded();
+		double getEncodeTime();
+		double getMaxEncodeTime();
+};
+
+#endif
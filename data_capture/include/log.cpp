@@ -19,6 +19,7 @@
  * 
  */
 
+#include <cstring>
 #include <stdexcept>
 
 #include "log.h"
@@ -29,7 +30,7 @@ Log::Log()
 	if (!verifyDirectory("logs"))
 		createDirectory("logs");
 	
-	this->openFile(("logs/" + currentDateTime() + ".txt").c_str());
+	this->openFile(("logs/" + currentDateTime() + ".bin").c_str());
 }
 
 Log::Log(std::string log_file)
@@ -44,11 +45,14 @@ Log::Log(const char *file)
 
 void Log::openFile(const char *file)
 {
-	fout.open(file);
+	fout.open(file, std::ios::binary);
     
 	if (!fout)
 		throw std::runtime_error("Error opening the log file!");
 	
+	buffer.resize(LOG_BUFFER_SIZE);
+	buffer_used = 0;
+	
 	this->WriteHeaderMessage();
 		
 	log_counter = 0;
@@ -56,54 +60,259 @@ void Log::openFile(const char *file)
 
 Log::~Log()
 {
+	this->Flush();
 	fout.close();
 }
 
 void Log::WriteHeaderMessage()
 {
-	fout << "# Flight log created on: " << currentDateTime() << std::endl;
-	fout << "#" << std::endl;
-	fout << "# Log code:" << std::endl;
-	fout << "#\tn = Log number" << std::endl;
-	fout << "#\tI = Frame number and elapsed time until the capture of this frame" << std::endl;
-	fout << "#\tB = Barometer data" << std::endl;
-	fout << "#\tM = Magnetometer data " << std::endl;
-	fout << "#\tA = IMU data" << std::endl;
-	fout << "#\tG = GPS data" << std::endl;
-	fout << "#" << std::endl;
-	fout << "# Example:" << std::endl;
-	fout << "# ~" << std::endl;
-	fout << "# n:111" << std::endl;
-	fout << "# I:25,10545" << std::endl;
-	fout << "# B:29.8,101281,0.249868" << std::endl;
-	fout << "# M:-1.90909,-9.36364,5.20408,276.654" << std::endl;
-	fout << "# A:-27,-462,7526,-2,0,0,0.996887,-0.0501709,0.0124512,0.0588379,-0.118879,-0.0189221,0.101705,-6.81128,-1.76105,-5.65696" << std::endl;
-	fout << "# G:-28.8068,-49.2238,21.1,0.16668,3,39,46,0,9,2,2016,9,86" << std::endl;
-	fout << "# ;" << std::endl;
-	fout << "#" << std::endl;
+	char header[LOG_HEADER_SIZE];
+	uint16_t version = LOG_VERSION;
+	uint16_t record_size = LOG_RECORD_SIZE;
+	
+	memset(header, 0, sizeof(header));
+	memcpy(header, LOG_MAGIC, 8);
+	memcpy(header + 8, &version, 2);
+	memcpy(header + 10, &record_size, 2);
+	strncpy(header + 12, currentDateTime().c_str(), LOG_HEADER_SIZE - 13);
+	
+	fout.write(header, sizeof(header));
+	fout.flush();
+	
+	flush_time = std::chrono::steady_clock::now();
 }
 
 void Log::Write(unsigned int frame_number, unsigned int elapsed_time, SensorsData *sData)
 {
-	fout << "~" << std::endl;
-	fout << "n:" << log_counter << std::endl;
-	fout << "I:" << frame_number << "," << elapsed_time << std::endl;
-	fout << "B:" << sData->temperature << "," << sData->pressure << "," << sData->altitude << std::endl;
-	fout << "M:" << sData->mag_x << "," << sData->mag_y << "," << sData->mag_z << "," << sData->heading << std::endl;
-	fout << "A:" << sData->ax << "," << sData->ay << "," << sData->az << ",";
-	fout << sData->gx << "," << sData->gy << "," << sData->gz << ",";
-	fout << sData->qw << "," << sData->qx << "," << sData->qy << "," << sData->qz << ",";
-	fout << sData->euler_yaw << "," << sData->euler_pitch << "," << sData->euler_roll << ",";
-	fout << sData->yaw << "," << sData->pitch << "," << sData->roll << std::endl;
-	fout << "G:";
-	fout << sData->latitude << "," << sData->longitude << "," << sData->gps_altitude << ",";
-	fout << sData->course << ",";
-	fout << sData->speed << ",";
-	fout << int(sData->hour) << "," << int(sData->minute) << "," << int(sData->second) << "," << int(sData->centisecond) << ",";
-	fout << int(sData->day) << "," << int(sData->month) << "," << int(sData->year) << ",";
-	fout << int(sData->satellites) << ",";
-	fout << int(sData->hdop) << std::endl;
-	fout << ";" << std::endl;
+	LogRecord record;
+	record.n = log_counter;
+	record.frame_number = frame_number;
+	record.elapsed_time = elapsed_time;
+	record.data = *sData;
+	
+	EncodeLogRecord(&record, &buffer[buffer_used]);
+	buffer_used += LOG_RECORD_SIZE;
+	
+	if ((buffer_used + LOG_RECORD_SIZE > buffer.size()) or
+		(std::chrono::steady_clock::now() - flush_time >= std::chrono::milliseconds(LOG_FLUSH_PERIOD)))
+		this->Flush();
 	
 	log_counter++;
 }
+
+void Log::Flush()
+{
+	if (buffer_used > 0)
+	{
+		fout.write(&buffer[0], buffer_used);
+		fout.flush();
+		buffer_used = 0;
+	}
+	
+	flush_time = std::chrono::steady_clock::now();
+}
+
+LogReader::LogReader(const char *file)
+{
+	fin.open(file, std::ios::binary);
+	
+	if (!fin)
+		throw std::runtime_error("Error opening the log file!");
+	
+	char header[LOG_HEADER_SIZE];
+	uint16_t version;
+	uint16_t record_size;
+	
+	if (!fin.read(header, sizeof(header)) or (memcmp(header, LOG_MAGIC, 8) != 0))
+		throw std::runtime_error("The file is not a binary flight log!");
+	
+	memcpy(&version, header + 8, 2);
+	memcpy(&record_size, header + 10, 2);
+	if ((version != LOG_VERSION) or (record_size != LOG_RECORD_SIZE))
+		throw std::runtime_error("Unsupported flight log version!");
+	
+	header[LOG_HEADER_SIZE - 1] = 0;
+	date = header + 12;
+}
+
+LogReader::~LogReader()
+{
+	fin.close();
+}
+
+// Next record (false at the end of the file or on a truncated record)
+bool LogReader::Read(LogRecord *record)
+{
+	char data[LOG_RECORD_SIZE];
+	
+	if (!fin.read(data, sizeof(data)))
+		return false;
+	
+	DecodeLogRecord(data, record);
+	
+	return true;
+}
+
+std::string LogReader::getDate()
+{
+	return date;
+}
+
+// Copies the fields one by one, to get the same layout on any compiler
+template<typename T> static void Put(char *&p, T value)
+{
+	memcpy(p, &value, sizeof(T));
+	p += sizeof(T);
+}
+
+template<typename T> static void Get(const char *&p, T &value)
+{
+	memcpy(&value, p, sizeof(T));
+	p += sizeof(T);
+}
+
+void EncodeLogRecord(const LogRecord *record, char *p)
+{
+	const SensorsData *d = &record->data;
+	
+	Put<uint32_t>(p, record->n);
+	Put<uint32_t>(p, record->frame_number);
+	Put<uint32_t>(p, record->elapsed_time);
+	Put(p, d->temperature);
+	Put(p, d->pressure);
+	Put(p, d->altitude);
+	Put(p, d->mag_x);
+	Put(p, d->mag_y);
+	Put(p, d->mag_z);
+	Put(p, d->heading);
+	Put(p, d->ax);
+	Put(p, d->ay);
+	Put(p, d->az);
+	Put(p, d->gx);
+	Put(p, d->gy);
+	Put(p, d->gz);
+	Put(p, d->qw);
+	Put(p, d->qx);
+	Put(p, d->qy);
+	Put(p, d->qz);
+	Put(p, d->euler_yaw);
+	Put(p, d->euler_pitch);
+	Put(p, d->euler_roll);
+	Put(p, d->yaw);
+	Put(p, d->pitch);
+	Put(p, d->roll);
+	Put(p, d->latitude);
+	Put(p, d->longitude);
+	Put(p, d->gps_altitude);
+	Put(p, d->course);
+	Put(p, d->speed);
+	Put(p, d->hour);
+	Put(p, d->minute);
+	Put(p, d->second);
+	Put(p, d->centisecond);
+	Put(p, d->day);
+	Put(p, d->month);
+	Put(p, d->year);
+	Put(p, d->satellites);
+	Put(p, d->hdop);
+}
+
+void DecodeLogRecord(const char *p, LogRecord *record)
+{
+	SensorsData *d = &record->data;
+	uint32_t value;
+	
+	Get(p, value);
+	record->n = value;
+	Get(p, value);
+	record->frame_number = value;
+	Get(p, value);
+	record->elapsed_time = value;
+	Get(p, d->temperature);
+	Get(p, d->pressure);
+	Get(p, d->altitude);
+	Get(p, d->mag_x);
+	Get(p, d->mag_y);
+	Get(p, d->mag_z);
+	Get(p, d->heading);
+	Get(p, d->ax);
+	Get(p, d->ay);
+	Get(p, d->az);
+	Get(p, d->gx);
+	Get(p, d->gy);
+	Get(p, d->gz);
+	Get(p, d->qw);
+	Get(p, d->qx);
+	Get(p, d->qy);
+	Get(p, d->qz);
+	Get(p, d->euler_yaw);
+	Get(p, d->euler_pitch);
+	Get(p, d->euler_roll);
+	Get(p, d->yaw);
+	Get(p, d->pitch);
+	Get(p, d->roll);
+	Get(p, d->latitude);
+	Get(p, d->longitude);
+	Get(p, d->gps_altitude);
+	Get(p, d->course);
+	Get(p, d->speed);
+	Get(p, d->hour);
+	Get(p, d->minute);
+	Get(p, d->second);
+	Get(p, d->centisecond);
+	Get(p, d->day);
+	Get(p, d->month);
+	Get(p, d->year);
+	Get(p, d->satellites);
+	Get(p, d->hdop);
+}
+
+// Text log format (the original flight log)
+void WriteTextHeader(std::ostream &out, std::string date)
+{
+	out << "# Flight log created on: " << date << "\n";
+	out << "#\n";
+	out << "# Log code:\n";
+	out << "#\tn = Log number\n";
+	out << "#\tI = Frame number and elapsed time until the capture of this frame\n";
+	out << "#\tB = Barometer data\n";
+	out << "#\tM = Magnetometer data \n";
+	out << "#\tA = IMU data\n";
+	out << "#\tG = GPS data\n";
+	out << "#\n";
+	out << "# Example:\n";
+	out << "# ~\n";
+	out << "# n:111\n";
+	out << "# I:25,10545\n";
+	out << "# B:29.8,101281,0.249868\n";
+	out << "# M:-1.90909,-9.36364,5.20408,276.654\n";
+	out << "# A:-27,-462,7526,-2,0,0,0.996887,-0.0501709,0.0124512,0.0588379,-0.118879,-0.0189221,0.101705,-6.81128,-1.76105,-5.65696\n";
+	out << "# G:-28.8068,-49.2238,21.1,0.16668,3,39,46,0,9,2,2016,9,86\n";
+	out << "# ;\n";
+	out << "#\n";
+}
+
+void WriteTextRecord(std::ostream &out, const LogRecord *record)
+{
+	const SensorsData *sData = &record->data;
+	
+	out << "~\n";
+	out << "n:" << record->n << "\n";
+	out << "I:" << record->frame_number << "," << record->elapsed_time << "\n";
+	out << "B:" << sData->temperature << "," << sData->pressure << "," << sData->altitude << "\n";
+	out << "M:" << sData->mag_x << "," << sData->mag_y << "," << sData->mag_z << "," << sData->heading << "\n";
+	out << "A:" << sData->ax << "," << sData->ay << "," << sData->az << ",";
+	out << sData->gx << "," << sData->gy << "," << sData->gz << ",";
+	out << sData->qw << "," << sData->qx << "," << sData->qy << "," << sData->qz << ",";
+	out << sData->euler_yaw << "," << sData->euler_pitch << "," << sData->euler_roll << ",";
+	out << sData->yaw << "," << sData->pitch << "," << sData->roll << "\n";
+	out << "G:";
+	out << sData->latitude << "," << sData->longitude << "," << sData->gps_altitude << ",";
+	out << sData->course << ",";
+	out << sData->speed << ",";
+	out << int(sData->hour) << "," << int(sData->minute) << "," << int(sData->second) << "," << int(sData->centisecond) << ",";
+	out << int(sData->day) << "," << int(sData->month) << "," << int(sData->year) << ",";
+	out << int(sData->satellites) << ",";
+	out << int(sData->hdop) << "\n";
+	out << ";\n";
+}
@@ -23,13 +23,46 @@
 #define LOG_H_
 
 #include <fstream>
+#include <ostream>
 #include <string>
+#include <vector>
+#include <chrono>
+#include <stdint.h>
 
 #include "sensors-data.h"
 
+/*
+ * Binary flight log.
+ * 
+ * The file starts with a LOG_HEADER_SIZE bytes header: the magic
+ * "TMUAVLOG", the format version and the record size (uint16_t each), and
+ * the creation date (NUL terminated). It is followed by fixed size records
+ * of LOG_RECORD_SIZE bytes, in the byte order of the machine: n, frame
+ * number and elapsed time (uint32_t), then the SensorsData fields in the
+ * order of the text log, each one with its own type. The records are
+ * buffered and written when the buffer is full or every LOG_FLUSH_PERIOD
+ * ms. log-convert writes a binary log in the text format.
+ */
+#define LOG_MAGIC "TMUAVLOG"
+#define LOG_VERSION 1
+#define LOG_HEADER_SIZE 64
+#define LOG_RECORD_SIZE 177
+#define LOG_BUFFER_SIZE (64*1024)
+#define LOG_FLUSH_PERIOD 1000
+
+struct LogRecord {
+	unsigned int n;
+	unsigned int frame_number;
+	unsigned int elapsed_time;
+	SensorsData data;
+};
+
 class Log {
 		std::ofstream fout;
 		unsigned int log_counter;
+		std::vector<char> buffer;
+		unsigned int buffer_used;
+		std::chrono::steady_clock::time_point flush_time;
 	public:
 		Log();
 		Log(std::string);
@@ -38,6 +71,22 @@ class Log {
 		~Log();
 		void WriteHeaderMessage();
 		void Write(unsigned int, unsigned int, SensorsData*);
+		void Flush();
 };
 
+class LogReader {
+		std::ifstream fin;
+		std::string date;
+	public:
+		LogReader(const char*);
+		~LogReader();
+		bool Read(LogRecord*);
+		std::string getDate();
+};
+
+void EncodeLogRecord(const LogRecord*, char*);
+void DecodeLogRecord(const char*, LogRecord*);
+void WriteTextHeader(std::ostream&, std::string);
+void WriteTextRecord(std::ostream&, const LogRecord*);
+
 #endif
@@ -20,32 +20,326 @@
  */
 
 #include <stdexcept>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/eventfd.h>
 
 #include "neo-6m.h"
 #include "serial.h"
+#include "scheduler.h"													// MonotonicTime()
 
-NEO_6M::NEO_6M(const char* adr)
+// Messages of a UBX solution
+#define UBX_POSLLH_DECODED 1
+#define UBX_VELNED_DECODED 2
+#define UBX_TIMEUTC_DECODED 4
+#define UBX_SOLUTION_DECODED 7
+
+NEO_6M::NEO_6M(const char* adr, int p)
 {
 	if ((fd = Serial_Open(adr, NEO_6M_BAUD_RATE)) < 0)
 		throw std::runtime_error("Error openning the serial device!");
-	else
-		gps = new TinyGPSPlus();
+	
+	if ((stop_fd = eventfd(0, EFD_CLOEXEC)) < 0)
+	{
+		Serial_Close(fd);
+		throw std::runtime_error("Error creating the GPS reader event!");
+	}
+	
+	protocol = p;
+	gps = new TinyGPSPlus();
+	
+	GpsFix f;
+	memset(&f, 0, sizeof(f));
+	f.age = UINT32_MAX;
+	fix.Store(f);
+	
+	ubx_fix = f;
+	ubx_frames = 0;
+	ubx_failures = 0;
+	ubx_itow = 0;
+	ubx_messages = 0;
+	ubx_time = 0;
+	satellites = 0;
+	hdop = 0;
+	fix_ok = false;
+	
+	if (protocol == NEO_6M_UBX)
+		this->Configure();
+	
+	reader = std::thread(&NEO_6M::Run, this);
 }
 
 NEO_6M::~NEO_6M()
 {
+	uint64_t one = 1;
+	if (write(stop_fd, &one, sizeof(one)) == sizeof(one))
+		reader.join();
+	else
+		reader.detach();
+	
 	delete gps;
 	
+	close(stop_fd);
 	Serial_Close(fd);
 }
 
-void NEO_6M::Read()
+// UBX mode configuration
+void NEO_6M::Configure()
+{
+	std::vector<uint8_t> frame;
+	std::vector<uint8_t> config;
+	
+	const uint8_t nmea_off[] = {NMEA_GLL, NMEA_GSA, NMEA_GSV, NMEA_VTG};
+	for(unsigned int i=0;i<sizeof(nmea_off);i++)
+	{
+		UBX_SetMessageRate(NMEA_CLASS, nmea_off[i], 0, frame);
+		config.insert(config.end(), frame.begin(), frame.end());
+	}
+	
+	const uint8_t nmea_1hz[] = {NMEA_GGA, NMEA_RMC};
+	for(unsigned int i=0;i<sizeof(nmea_1hz);i++)
+	{
+		UBX_SetMessageRate(NMEA_CLASS, nmea_1hz[i], 1000/NEO_6M_UBX_PERIOD, frame);
+		config.insert(config.end(), frame.begin(), frame.end());
+	}
+	
+	const uint8_t ubx_5hz[] = {UBX_NAV_POSLLH, UBX_NAV_VELNED, UBX_NAV_TIMEUTC};
+	for(unsigned int i=0;i<sizeof(ubx_5hz);i++)
+	{
+		UBX_SetMessageRate(UBX_NAV, ubx_5hz[i], 1, frame);
+		config.insert(config.end(), frame.begin(), frame.end());
+	}
+	
+	const uint8_t ubx_1hz[] = {UBX_NAV_SOL, UBX_NAV_DOP};
+	for(unsigned int i=0;i<sizeof(ubx_1hz);i++)
+	{
+		UBX_SetMessageRate(UBX_NAV, ubx_1hz[i], 1000/NEO_6M_UBX_PERIOD, frame);
+		config.insert(config.end(), frame.begin(), frame.end());
+	}
+	
+	UBX_SetRate(NEO_6M_UBX_PERIOD, frame);
+	config.insert(config.end(), frame.begin(), frame.end());
+	
+	unsigned int sent = 0;
+	while(sent < config.size())
+	{
+		ssize_t n = write(fd, &config[sent], config.size() - sent);
+		if ((n < 0) and (errno != EINTR) and (errno != EAGAIN))
+			throw std::runtime_error("Error configuring the GPS receiver!");
+		if (n > 0)
+			sent += n;
+	}
+}
+
+// Reader thread: one read() call for all the characters received
+void NEO_6M::Run()
+{
+	char buffer[NEO_6M_BUFFER_SIZE];
+	struct pollfd pfd[2];
+	
+	pfd[0].fd = fd;
+	pfd[0].events = POLLIN;
+	pfd[1].fd = stop_fd;
+	pfd[1].events = POLLIN;
+	
+	while(true)
+	{
+		if (poll(pfd, 2, -1) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		
+		if (pfd[1].revents)
+			break;
+		
+		if (pfd[0].revents & (POLLERR | POLLNVAL))
+			break;
+		
+		int n = Serial_Read(fd, buffer, sizeof(buffer));
+		if ((n < 0) and (errno != EINTR) and (errno != EAGAIN))
+			break;
+		if ((n == 0) and (pfd[0].revents & POLLHUP))
+			break;
+		
+		for(int i=0;i<n;i++)
+		{
+			int status = ubx.Parse(buffer[i]);
+			
+			if (status == UBX_FRAME)
+				this->DecodeUBX();
+			else if (status == UBX_NOT_UBX)
+			{
+				// A sentence was completed (NMEA is the fallback of UBX)
+				if (gps->encode(buffer[i]) and
+					((protocol == NEO_6M_NMEA) or (MonotonicTime() - ubx_time > NEO_6M_UBX_TIMEOUT)))
+					this->Publish();
+			}
+		}
+		
+		ubx_frames.store(ubx.getFrames(), std::memory_order_release);
+		ubx_failures.store(ubx.getFailedChecksum(), std::memory_order_release);
+	}
+}
+
+void NEO_6M::Publish()
+{
+	GpsFix f;
+	
+	f.latitude = gps->location.lat();
+	f.longitude = gps->location.lng();
+	f.altitude = gps->altitude.meters();
+	f.course = gps->course.deg();
+	f.speed = gps->speed.kmph();
+	f.centisecond = gps->time.centisecond();
+	f.second = gps->time.second();
+	f.minute = gps->time.minute();
+	f.hour = gps->time.hour();
+	f.day = gps->date.day();
+	f.month = gps->date.month();
+	f.year = gps->date.year();
+	f.satellites = gps->satellites.value();
+	f.hdop = gps->hdop.value();
+	f.valid = gps->location.isValid();
+	f.age = gps->location.age();
+	f.sentences = gps->passedChecksum();
+	f.time = MonotonicTime();
+	f.protocol = NEO_6M_NMEA;
+	
+	fix.Store(f);
+}
+
+void NEO_6M::BeginSolution(uint32_t itow)
+{
+	if (itow != ubx_itow)
+	{
+		ubx_itow = itow;
+		ubx_messages = 0;
+	}
+}
+
+// Decodes the last UBX frame. A solution is published when its position,
+// velocity and time messages have been decoded.
+void NEO_6M::DecodeUBX()
+{
+	const uint8_t *p = ubx.getPayload();
+	uint16_t length = ubx.getLength();
+	
+	if (ubx.getClass() != UBX_NAV)										// e.g. the ACK of the configuration
+		return;
+	
+	switch(ubx.getId())
+	{
+		case UBX_NAV_POSLLH:
+			if (length < 28)
+				return;
+			this->BeginSolution(UBX_U4(p));
+			ubx_fix.longitude = UBX_I4(p + 4)*1e-7;
+			ubx_fix.latitude = UBX_I4(p + 8)*1e-7;
+			ubx_fix.altitude = UBX_I4(p + 16)/1000.0;					// Above mean sea level
+			ubx_messages |= UBX_POSLLH_DECODED;
+			break;
+		case UBX_NAV_VELNED:
+			if (length < 36)
+				return;
+			this->BeginSolution(UBX_U4(p));
+			ubx_fix.speed = UBX_U4(p + 20)*0.036;						// Ground speed, cm/s to km/h
+			ubx_fix.course = UBX_I4(p + 24)*1e-5;
+			ubx_messages |= UBX_VELNED_DECODED;
+			break;
+		case UBX_NAV_TIMEUTC:
+			if (length < 20)
+				return;
+			this->BeginSolution(UBX_U4(p));
+			ubx_fix.year = UBX_U2(p + 12);
+			ubx_fix.month = p[14];
+			ubx_fix.day = p[15];
+			ubx_fix.hour = p[16];
+			ubx_fix.minute = p[17];
+			ubx_fix.second = p[18];
+			ubx_fix.centisecond = (UBX_I4(p + 8) > 0)? UBX_I4(p + 8)/10000000:0;
+			ubx_messages |= UBX_TIMEUTC_DECODED;
+			break;
+		case UBX_NAV_SOL:
+			if (length < 52)
+				return;
+			fix_ok = ((p[10] == 2) or (p[10] == 3)) and (p[11] & 0x01);	// 2D/3D fix, within the accuracy limits
+			satellites = p[47];
+			return;
+		case UBX_NAV_DOP:
+			if (length < 18)
+				return;
+			hdop = UBX_U2(p + 12);										// 0.01 units, as the NMEA HDOP of TinyGPSPlus
+			return;
+		case UBX_NAV_PVT:
+			if (length < 84)
+				return;
+			this->BeginSolution(UBX_U4(p));
+			ubx_fix.year = UBX_U2(p + 4);
+			ubx_fix.month = p[6];
+			ubx_fix.day = p[7];
+			ubx_fix.hour = p[8];
+			ubx_fix.minute = p[9];
+			ubx_fix.second = p[10];
+			ubx_fix.centisecond = (UBX_I4(p + 16) > 0)? UBX_I4(p + 16)/10000000:0;
+			fix_ok = ((p[20] == 2) or (p[20] == 3)) and (p[21] & 0x01);
+			satellites = p[23];
+			ubx_fix.longitude = UBX_I4(p + 24)*1e-7;
+			ubx_fix.latitude = UBX_I4(p + 28)*1e-7;
+			ubx_fix.altitude = UBX_I4(p + 36)/1000.0;
+			ubx_fix.speed = UBX_I4(p + 60)*0.0036;						// Ground speed, mm/s to km/h
+			ubx_fix.course = UBX_I4(p + 64)*1e-5;
+			if (hdop == 0)
+				hdop = UBX_U2(p + 76);									// PDOP, until a NAV-DOP arrives
+			ubx_messages = UBX_SOLUTION_DECODED;
+			break;
+		default:
+			return;
+	}
+	
+	if (ubx_messages != UBX_SOLUTION_DECODED)
+		return;
+	
+	ubx_time = MonotonicTime();
+	ubx_fix.satellites = satellites;
+	ubx_fix.hdop = hdop;
+	ubx_fix.valid = fix_ok;
+	ubx_fix.age = 0;
+	ubx_fix.sentences = ubx.getFrames();
+	ubx_fix.time = ubx_time;
+	ubx_fix.protocol = NEO_6M_UBX;
+	ubx_messages = 0;
+	
+	fix.Store(ubx_fix);
+}
+
+GpsFix NEO_6M::getFix()
+{
+	return fix.Load();
+}
+
+// Age of the last location now (ms), UINT32_MAX if there is none
+uint32_t NEO_6M::getFixAge()
+{
+	GpsFix f = fix.Load();
+	
+	if (!f.valid)
+		return UINT32_MAX;
+	
+	return f.age + (MonotonicTime() - f.time)/1000000;
+}
+
+// Valid UBX frames received
+uint32_t NEO_6M::getUBXFrames()
 {
-	while(Serial_DataAvail(fd))
-		gps->encode(Serial_Getchar(fd));
+	return ubx_frames.load(std::memory_order_acquire);
 }
 
-TinyGPSPlus NEO_6M::getData()
+// UBX frames dropped for a bad checksum or length
+uint32_t NEO_6M::getUBXFailures()
 {
-	return *gps;
+	return ubx_failures.load(std::memory_order_acquire);
 }
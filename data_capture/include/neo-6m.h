@@ -22,19 +22,93 @@
 #ifndef NEO_6M_H_
 #define NEO_6M_H_
 
+#include <stdint.h>
+#include <thread>
+#include <atomic>
+
 #include "TinyGPS++.h"
+#include "ubx.h"
+#include "seqlock.h"
 
 #define RPI_SERIAL_ADDRESS "/dev/ttyAMA0"
 #define NEO_6M_BAUD_RATE 9600
+#define NEO_6M_BUFFER_SIZE 256
+
+// Protocols
+#define NEO_6M_NMEA 0													// Receiver defaults, 1 Hz
+#define NEO_6M_UBX 1													// UBX navigation messages, 5 Hz
+
+#define NEO_6M_UBX_PERIOD 200											// ms
+#define NEO_6M_UBX_TIMEOUT 2000000000ULL								// ns without UBX solutions to use NMEA again
+
+// GPS data of the last navigation solution
+struct GpsFix {
+	double latitude;
+	double longitude;
+	double altitude;													// m
+	double course;														// deg
+	double speed;														// km/h
+	uint8_t centisecond;
+	uint8_t second;
+	uint8_t minute;
+	uint8_t hour;
+	uint8_t day;
+	uint8_t month;
+	uint16_t year;
+	int8_t satellites;
+	double hdop;
+	bool valid;															// Location valid
+	uint32_t age;														// Age of the location when decoded (ms)
+	uint32_t sentences;													// Sentences (or UBX frames) decoded so far
+	uint64_t time;														// Decoding time (CLOCK_MONOTONIC, ns)
+	uint8_t protocol;
+};
 
+/*
+ * NEO-6M GPS receiver.
+ * 
+ * A thread waits for the serial data with poll(), reads it in blocks and
+ * decodes the NMEA sentences. Each complete sentence publishes a new fix
+ * through a seqlock, so getFix() returns a coherent copy of one fix without
+ * ever blocking the reader thread.
+ * 
+ * In UBX mode the receiver is configured for 5 Hz navigation solutions and
+ * the NAV-POSLLH, NAV-VELNED and NAV-TIMEUTC messages of each solution (the
+ * NEO-6M has no NAV-PVT, which is also decoded if a newer receiver sends
+ * it). NAV-SOL and NAV-DOP give the satellites and the HDOP once a second.
+ * GGA and RMC stay enabled at 1 Hz and are used if no UBX solution arrives
+ * for NEO_6M_UBX_TIMEOUT. The rest of the NMEA sentences are disabled to
+ * keep the 9600 baud link below 80 % of its capacity.
+ */
 class NEO_6M {
 		int fd;
+		int stop_fd;													// eventfd that stops the thread
+		int protocol;
 		TinyGPSPlus *gps;
+		UBXParser ubx;
+		std::atomic<uint32_t> ubx_frames;								// Parser counters, for the other threads
+		std::atomic<uint32_t> ubx_failures;
+		GpsFix ubx_fix;													// Solution being decoded
+		uint32_t ubx_itow;												// Its GPS time of week (ms)
+		int ubx_messages;												// Its messages decoded so far
+		uint64_t ubx_time;												// Last UBX solution
+		int satellites;													// From NAV-SOL
+		double hdop;													// From NAV-DOP
+		bool fix_ok;
+		Seqlock<GpsFix> fix;
+		std::thread reader;
+		void Configure();
+		void Run();
+		void Publish();
+		void DecodeUBX();
+		void BeginSolution(uint32_t);
 	public:
-		NEO_6M(const char* adr=RPI_SERIAL_ADDRESS);
+		NEO_6M(const char* adr=RPI_SERIAL_ADDRESS, int p=NEO_6M_UBX);
 		~NEO_6M();
-		void Read();
-		TinyGPSPlus getData();
+		GpsFix getFix();
+		uint32_t getFixAge();
+		uint32_t getUBXFrames();
+		uint32_t getUBXFailures();
 };
 
 #endif
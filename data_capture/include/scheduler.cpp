@@ -0,0 +1,136 @@
+/*
+ * Traffic Management UAV Data Capture.
+ * A program to capture images and sensors data with Raspberry Pi.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#include <cerrno>
+#include <stdexcept>
+
+#include "scheduler.h"
+
+uint64_t MonotonicTime()
+{
+	struct timespec t;
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	
+	return uint64_t(t.tv_sec)*1000000000 + t.tv_nsec;
+}
+
+Scheduler::Scheduler()
+{
+	start = MonotonicTime();
+}
+
+Scheduler::~Scheduler()
+{
+	
+}
+
+// Adds a task with the given period (us), first released offset us after
+// the scheduler creation
+unsigned int Scheduler::AddTask(std::string name, unsigned int period, std::function<void()> run, unsigned int offset)
+{
+	if (period == 0)
+		throw std::runtime_error("Invalid task period!");
+	
+	SchedulerTask task;
+	task.name = name;
+	task.period = uint64_t(period)*1000;
+	task.deadline = start + uint64_t(offset)*1000;
+	task.run = run;
+	task.runs = task.overruns = 0;
+	task.max_latency = task.max_time = 0;
+	
+	tasks.push_back(task);
+	
+	return tasks.size() - 1;
+}
+
+// Sleeps until the next release and runs the tasks that are due
+void Scheduler::RunOnce()
+{
+	if (tasks.empty())
+		return;
+	
+	uint64_t next = tasks[0].deadline;
+	for(unsigned int i=1;i<tasks.size();i++)
+		if (tasks[i].deadline < next)
+			next = tasks[i].deadline;
+	
+	struct timespec t;
+	t.tv_sec = next/1000000000;
+	t.tv_nsec = next%1000000000;
+	while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &t, NULL) == EINTR)
+		;
+	
+	for(unsigned int i=0;i<tasks.size();i++)
+	{
+		SchedulerTask &task = tasks[i];
+		
+		uint64_t task_start = MonotonicTime();
+		if (task_start < task.deadline)
+			continue;
+		
+		if (task_start - task.deadline > task.max_latency)
+			task.max_latency = task_start - task.deadline;
+		
+		task.run();
+		task.runs++;
+		
+		uint64_t task_end = MonotonicTime();
+		if (task_end - task_start > task.max_time)
+			task.max_time = task_end - task_start;
+		
+		// Next deadline in the future, counting the skipped ones
+		task.deadline += task.period;
+		if (task.deadline <= task_end)
+		{
+			uint64_t missed = (task_end - task.deadline)/task.period + 1;
+			task.overruns += missed;
+			task.deadline += missed*task.period;
+		}
+	}
+}
+
+void Scheduler::Run()
+{
+	while(true)
+		this->RunOnce();
+}
+
+unsigned int Scheduler::getTasks()
+{
+	return tasks.size();
+}
+
+const SchedulerTask& Scheduler::getTask(unsigned int i)
+{
+	return tasks[i];
+}
+
+void Scheduler::PrintStats(std::ostream &out)
+{
+	for(unsigned int i=0;i<tasks.size();i++)
+	{
+		out << tasks[i].name << ": " << tasks[i].runs << " runs, "
+			<< tasks[i].overruns << " overruns, latency max "
+			<< tasks[i].max_latency/1000.0 << " us, time max "
+			<< tasks[i].max_time/1000.0 << " us" << std::endl;
+	}
+}
@@ -0,0 +1,69 @@
+/*
+ * Traffic Management UAV Data Capture.
+ * A program to capture images and sensors data with Raspberry Pi.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <functional>
+#include <stdint.h>
+#include <time.h>
+
+struct SchedulerTask {
+	std::string name;
+	uint64_t period;													// ns
+	uint64_t deadline;													// Next release (CLOCK_MONOTONIC, ns)
+	std::function<void()> run;
+	unsigned long runs;
+	unsigned long overruns;												// Releases missed because the thread was late
+	uint64_t max_latency;												// Release to start, ns
+	uint64_t max_time;													// Run time, ns
+};
+
+/*
+ * Multi-rate periodic scheduler.
+ * 
+ * Each task is released at absolute deadlines of CLOCK_MONOTONIC (the
+ * first one plus a multiple of its period), and the thread sleeps with
+ * clock_nanosleep() until the next one, so the time taken by the tasks
+ * does not make the periods drift. When a task is so late that it misses
+ * whole periods, they are counted as overruns and skipped. Tasks due at
+ * the same time run in the order they were added.
+ */
+class Scheduler {
+		std::vector<SchedulerTask> tasks;
+		uint64_t start;
+	public:
+		Scheduler();
+		~Scheduler();
+		unsigned int AddTask(std::string, unsigned int, std::function<void()>, unsigned int offset=0);
+		void RunOnce();
+		void Run();
+		unsigned int getTasks();
+		const SchedulerTask& getTask(unsigned int);
+		void PrintStats(std::ostream&);
+};
+
+uint64_t MonotonicTime();
+
+#endif
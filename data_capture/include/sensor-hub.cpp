@@ -0,0 +1,75 @@
+/*
+ * Traffic Management UAV Data Capture.
+ * A program to capture images and sensors data with Raspberry Pi.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#include <cstring>
+
+#include "sensor-hub.h"
+#include "scheduler.h"													// MonotonicTime()
+
+SensorHub::SensorHub()
+{
+	SensorSnapshot s;
+	memset(&s, 0, sizeof(s));
+	snapshot.Store(s);
+	
+	FrameStamp f;
+	f.n = 0;
+	f.time = 0;
+	frame.Store(f);
+	
+	published = 0;
+}
+
+SensorHub::~SensorHub()
+{
+	
+}
+
+// Sensors thread only
+void SensorHub::Publish(const SensorsData &data)
+{
+	SensorSnapshot s;
+	s.data = data;
+	s.time = MonotonicTime();
+	s.n = ++published;
+	
+	snapshot.Store(s);
+}
+
+SensorSnapshot SensorHub::getSnapshot()
+{
+	return snapshot.Load();
+}
+
+// Camera thread only
+void SensorHub::PublishFrame(unsigned int n, unsigned int time)
+{
+	FrameStamp f;
+	f.n = n;
+	f.time = time;
+	
+	frame.Store(f);
+}
+
+FrameStamp SensorHub::getFrame()
+{
+	return frame.Load();
+}
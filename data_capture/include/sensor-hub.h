@@ -0,0 +1,64 @@
+/*
+ * Traffic Management UAV Data Capture.
+ * A program to capture images and sensors data with Raspberry Pi.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#ifndef SENSOR_HUB_H_
+#define SENSOR_HUB_H_
+
+#include <stdint.h>
+
+#include "sensors-data.h"
+#include "seqlock.h"
+
+struct SensorSnapshot {
+	SensorsData data;
+	uint64_t time;														// Publication time (CLOCK_MONOTONIC, ns)
+	unsigned int n;														// Publications so far
+};
+
+// Last captured frame
+struct FrameStamp {
+	unsigned int n;														// Frames captured so far
+	unsigned int time;													// Capture time of the last one (ms since the start)
+};
+
+/*
+ * Latest sensors data, shared between threads.
+ * 
+ * The sensors thread publishes its SensorsData after each read and any
+ * thread (e.g. the camera, to tag each frame) gets a coherent copy through
+ * a seqlock. Neither side ever blocks the other. The camera publishes the
+ * number and the capture time of its last frame the same way, so the log
+ * always gets a matching pair.
+ */
+class SensorHub {
+		Seqlock<SensorSnapshot> snapshot;
+		Seqlock<FrameStamp> frame;
+		unsigned int published;
+	public:
+		SensorHub();
+		~SensorHub();
+		void Publish(const SensorsData&);
+		SensorSnapshot getSnapshot();
+		void PublishFrame(unsigned int, unsigned int);
+		FrameStamp getFrame();
+};
+
+#endif
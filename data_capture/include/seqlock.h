@@ -0,0 +1,100 @@
+/*
+ * Traffic Management UAV Data Capture.
+ * A program to capture images and sensors data with Raspberry Pi.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#ifndef SEQLOCK_H_
+#define SEQLOCK_H_
+
+#include <atomic>
+#include <thread>
+#include <cstring>
+#include <stdint.h>
+
+/*
+ * Single writer sequence lock.
+ * 
+ * Holds a trivially copyable value that one thread writes and any number
+ * of threads read, without blocking the writer. The sequence number is odd
+ * while a write is in progress, and a reader copies the value again if the
+ * number changed during its copy. The value is kept as atomic words, so a
+ * torn copy is never used and there is no data race.
+ */
+template<typename T> class Seqlock {
+		static const unsigned int WORDS = (sizeof(T) + sizeof(uint64_t) - 1)/sizeof(uint64_t);
+		std::atomic<unsigned int> seq;
+		std::atomic<uint64_t> data[WORDS];
+	public:
+		Seqlock()
+		{
+			seq.store(0, std::memory_order_relaxed);
+			for(unsigned int i=0;i<WORDS;i++)
+				data[i].store(0, std::memory_order_relaxed);
+		}
+		
+		// Writer side
+		void Store(const T &value)
+		{
+			uint64_t words[WORDS];
+			words[WORDS - 1] = 0;
+			memcpy(words, &value, sizeof(T));
+			
+			unsigned int s = seq.load(std::memory_order_relaxed);
+			seq.store(s + 1, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release);
+			
+			for(unsigned int i=0;i<WORDS;i++)
+				data[i].store(words[i], std::memory_order_relaxed);
+			
+			seq.store(s + 2, std::memory_order_release);
+		}
+		
+		// Reader side: a coherent copy of the last value stored
+		T Load() const
+		{
+			uint64_t words[WORDS];
+			unsigned int s1, s2;
+			
+			do
+			{
+				while((s1 = seq.load(std::memory_order_acquire)) & 1)
+					std::this_thread::yield();
+				
+				for(unsigned int i=0;i<WORDS;i++)
+					words[i] = data[i].load(std::memory_order_relaxed);
+				
+				std::atomic_thread_fence(std::memory_order_acquire);
+				s2 = seq.load(std::memory_order_relaxed);
+			}
+			while(s1 != s2);
+			
+			T value;
+			memcpy(&value, words, sizeof(T));
+			
+			return value;
+		}
+		
+		// Number of values stored
+		unsigned int getVersion() const
+		{
+			return seq.load(std::memory_order_acquire)/2;
+		}
+};
+
+#endif
@@ -130,3 +130,9 @@ int Serial_Getchar (const int fd)
 
 	return ((int)x) & 0xFF;
 }
+
+// Reads up to length bytes (returns the number of bytes read, or -1)
+int Serial_Read (const int fd, char *buffer, const int length)
+{
+	return read(fd, buffer, length);
+}
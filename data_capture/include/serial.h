@@ -30,5 +30,6 @@ int Serial_Open(const char*, const int);
 void Serial_Close (const int);
 int Serial_DataAvail (const int);
 int Serial_Getchar (const int);
+int Serial_Read (const int, char*, const int);
 
 #endif
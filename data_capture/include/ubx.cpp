@@ -0,0 +1,199 @@
+/*
+ * Traffic Management UAV Data Capture.
+ * A program to capture images and sensors data with Raspberry Pi.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#include "ubx.h"
+
+// Parser states
+#define UBX_SYNC_1_STATE 0
+#define UBX_SYNC_2_STATE 1
+#define UBX_CLASS_STATE 2
+#define UBX_ID_STATE 3
+#define UBX_LENGTH_1_STATE 4
+#define UBX_LENGTH_2_STATE 5
+#define UBX_PAYLOAD_STATE 6
+#define UBX_CK_A_STATE 7
+#define UBX_CK_B_STATE 8
+
+UBXParser::UBXParser()
+{
+	state = UBX_SYNC_1_STATE;
+	frames = 0;
+	failed = 0;
+}
+
+int UBXParser::Parse(uint8_t c)
+{
+	switch(state)
+	{
+		case UBX_SYNC_1_STATE:
+			if (c != UBX_SYNC_1)
+				return UBX_NOT_UBX;
+			state = UBX_SYNC_2_STATE;
+			return UBX_PENDING;
+		case UBX_SYNC_2_STATE:
+			if (c != UBX_SYNC_2)
+			{
+				state = UBX_SYNC_1_STATE;
+				return this->Parse(c);
+			}
+			state = UBX_CLASS_STATE;
+			ck_a = ck_b = 0;
+			return UBX_PENDING;
+		case UBX_PAYLOAD_STATE:
+			payload[count++] = c;
+			if (count == length)
+				state = UBX_CK_A_STATE;
+			break;
+		case UBX_CK_A_STATE:
+			if (c != ck_a)
+			{
+				failed++;
+				state = UBX_SYNC_1_STATE;
+			}
+			else
+				state = UBX_CK_B_STATE;
+			return UBX_PENDING;
+		case UBX_CK_B_STATE:
+			state = UBX_SYNC_1_STATE;
+			if (c != ck_b)
+			{
+				failed++;
+				return UBX_PENDING;
+			}
+			frames++;
+			return UBX_FRAME;
+		case UBX_CLASS_STATE:
+			msg_class = c;
+			state = UBX_ID_STATE;
+			break;
+		case UBX_ID_STATE:
+			msg_id = c;
+			state = UBX_LENGTH_1_STATE;
+			break;
+		case UBX_LENGTH_1_STATE:
+			length = c;
+			state = UBX_LENGTH_2_STATE;
+			break;
+		case UBX_LENGTH_2_STATE:
+			length |= uint16_t(c) << 8;
+			count = 0;
+			if (length > UBX_MAX_PAYLOAD)
+			{
+				failed++;
+				state = UBX_SYNC_1_STATE;
+				return UBX_PENDING;
+			}
+			state = (length > 0)? UBX_PAYLOAD_STATE:UBX_CK_A_STATE;
+			break;
+	}
+	
+	// 8-bit Fletcher checksum, from the class to the end of the payload
+	ck_a += c;
+	ck_b += ck_a;
+	
+	return UBX_PENDING;
+}
+
+uint8_t UBXParser::getClass()
+{
+	return msg_class;
+}
+
+uint8_t UBXParser::getId()
+{
+	return msg_id;
+}
+
+uint16_t UBXParser::getLength()
+{
+	return length;
+}
+
+const uint8_t* UBXParser::getPayload()
+{
+	return payload;
+}
+
+uint32_t UBXParser::getFrames()
+{
+	return frames;
+}
+
+uint32_t UBXParser::getFailedChecksum()
+{
+	return failed;
+}
+
+// Builds a frame (with the sync chars and the checksum)
+void UBX_Frame(uint8_t msg_class, uint8_t msg_id, const uint8_t *payload, uint16_t length, std::vector<uint8_t> &frame)
+{
+	frame.clear();
+	frame.push_back(UBX_SYNC_1);
+	frame.push_back(UBX_SYNC_2);
+	frame.push_back(msg_class);
+	frame.push_back(msg_id);
+	frame.push_back(length & 0xFF);
+	frame.push_back(length >> 8);
+	frame.insert(frame.end(), payload, payload + length);
+	
+	uint8_t ck_a = 0;
+	uint8_t ck_b = 0;
+	for(unsigned int i=2;i<frame.size();i++)
+	{
+		ck_a += frame[i];
+		ck_b += ck_a;
+	}
+	
+	frame.push_back(ck_a);
+	frame.push_back(ck_b);
+}
+
+// CFG-RATE: measurement period (ms), one navigation solution per measurement, GPS time
+void UBX_SetRate(uint16_t period, std::vector<uint8_t> &frame)
+{
+	uint8_t payload[6] = {uint8_t(period & 0xFF), uint8_t(period >> 8), 1, 0, 1, 0};
+	
+	UBX_Frame(UBX_CFG, UBX_CFG_RATE, payload, sizeof(payload), frame);
+}
+
+// CFG-MSG: output rate of a message on the current port (once every rate
+// navigation solutions, 0 = disabled)
+void UBX_SetMessageRate(uint8_t msg_class, uint8_t msg_id, uint8_t rate, std::vector<uint8_t> &frame)
+{
+	uint8_t payload[3] = {msg_class, msg_id, rate};
+	
+	UBX_Frame(UBX_CFG, UBX_CFG_MSG, payload, sizeof(payload), frame);
+}
+
+uint16_t UBX_U2(const uint8_t *p)
+{
+	return p[0] | (uint16_t(p[1]) << 8);
+}
+
+uint32_t UBX_U4(const uint8_t *p)
+{
+	return p[0] | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+int32_t UBX_I4(const uint8_t *p)
+{
+	return int32_t(UBX_U4(p));
+}
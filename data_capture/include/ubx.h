@@ -0,0 +1,98 @@
+/*
+ * Traffic Management UAV Data Capture.
+ * A program to capture images and sensors data with Raspberry Pi.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#ifndef UBX_H_
+#define UBX_H_
+
+#include <vector>
+#include <stdint.h>
+
+// Frame: sync chars, class, id, length (little endian), payload, checksum
+#define UBX_SYNC_1 0xB5
+#define UBX_SYNC_2 0x62
+#define UBX_MAX_PAYLOAD 256
+
+// Classes and messages
+#define UBX_NAV 0x01
+#define UBX_NAV_POSLLH 0x02
+#define UBX_NAV_DOP 0x04
+#define UBX_NAV_SOL 0x06
+#define UBX_NAV_PVT 0x07												// u-blox 7 and later
+#define UBX_NAV_VELNED 0x12
+#define UBX_NAV_TIMEUTC 0x21
+#define UBX_ACK 0x05
+#define UBX_ACK_NAK 0x00
+#define UBX_ACK_ACK 0x01
+#define UBX_CFG 0x06
+#define UBX_CFG_MSG 0x01
+#define UBX_CFG_RATE 0x08
+#define NMEA_CLASS 0xF0
+#define NMEA_GGA 0x00
+#define NMEA_GLL 0x01
+#define NMEA_GSA 0x02
+#define NMEA_GSV 0x03
+#define NMEA_RMC 0x04
+#define NMEA_VTG 0x05
+
+// UBXParser::Parse() results
+#define UBX_NOT_UBX 0													// The byte is not part of a UBX frame
+#define UBX_PENDING 1
+#define UBX_FRAME 2														// A valid frame was completed
+
+/*
+ * u-blox UBX binary protocol parser.
+ * 
+ * Parse() takes the bytes one by one and validates the checksum of each
+ * frame. The bytes that can not start a frame are given back, so the same
+ * stream can also carry NMEA sentences.
+ */
+class UBXParser {
+		int state;
+		uint8_t msg_class;
+		uint8_t msg_id;
+		uint16_t length;
+		uint16_t count;
+		uint8_t ck_a;
+		uint8_t ck_b;
+		uint8_t payload[UBX_MAX_PAYLOAD];
+		uint32_t frames;
+		uint32_t failed;
+	public:
+		UBXParser();
+		int Parse(uint8_t);
+		uint8_t getClass();
+		uint8_t getId();
+		uint16_t getLength();
+		const uint8_t* getPayload();
+		uint32_t getFrames();
+		uint32_t getFailedChecksum();
+};
+
+void UBX_Frame(uint8_t, uint8_t, const uint8_t*, uint16_t, std::vector<uint8_t>&);
+void UBX_SetRate(uint16_t, std::vector<uint8_t>&);
+void UBX_SetMessageRate(uint8_t, uint8_t, uint8_t, std::vector<uint8_t>&);
+
+// Little endian payload fields
+uint16_t UBX_U2(const uint8_t*);
+uint32_t UBX_U4(const uint8_t*);
+int32_t UBX_I4(const uint8_t*);
+
+#endif
@@ -0,0 +1,74 @@
+/*
+ * Traffic Management UAV Data Capture.
+ * A program to capture images and sensors data with Raspberry Pi.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+/*
+ * Writes a binary flight log (logs/<date>.bin) in the text format.
+ * 
+ * Usage: log-convert LOG.bin [LOG.txt]
+ * 
+ * Without an output file, the text is written to the standard output.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <stdexcept>
+
+#include "include/log.h"
+
+using namespace std;
+
+int main(int argc, char **argv)
+{
+	if ((argc < 2) or (argc > 3))
+	{
+		cerr << "Usage: " << argv[0] << " LOG.bin [LOG.txt]" << endl;
+		return 1;
+	}
+	
+	try
+	{
+		LogReader log(argv[1]);
+		ofstream fout;
+		
+		if (argc == 3)
+		{
+			fout.open(argv[2]);
+			if (!fout)
+				throw runtime_error("Error opening the output file!");
+		}
+		
+		ostream &out = (argc == 3)? fout:cout;
+		LogRecord record;
+		
+		WriteTextHeader(out, log.getDate());
+		while(log.Read(&record))
+			WriteTextRecord(out, &record);
+		
+		out.flush();
+	}
+	catch(exception &e)
+	{
+		cerr << e.what() << endl;
+		return 1;
+	}
+	
+	return 0;
+}
@@ -22,10 +22,10 @@
 #include <unistd.h>
 #include <stdint.h>
 #include <sstream>
+#include <cstring>
 #include <cmath>
 #include <thread>
-#include <mutex>
-#include <vector>
+#include <iostream>
 #include <stdexcept>
 #include <chrono>
 #include <opencv2/opencv.hpp>
@@ -37,29 +37,43 @@
 #include "include/log.h"
 #include "include/sensors-data.h"
 #include "include/aux.h"
+#include "include/frame-ring.h"
+#include "include/jpeg-pool.h"
+#include "include/scheduler.h"
+#include "include/imu-stream.h"
+#include "include/sensor-hub.h"
 
 //#define VIDEO_OUTPUT
 
+#define FRAME_RING_SIZE 32												// Frames waiting to be recorded (the camera never waits)
+#define FRAME_RING_POLICY FRAME_RING_DROP_OLDEST
+#define RECORD_WAIT_TIMEOUT 1000										// ms, to report the dropped frames while idle
+#define RECORD_STATS_PERIOD 10											// s
+
 #define MAG_DECLINATION -0.3349
 
+#define DMP_PACKET_PERIOD 10000000										// ns, 200 Hz/(1 + DMP_FIFO_RATE)
+#define DMP_BURST_PACKETS 6												// 252 bytes, the most of one FIFO read
+
+// Sensors sampling periods (us)
+#define IMU_PERIOD 50000												// 5 DMP packets (the FIFO holds 24)
+#define BAROMETER_PERIOD 10000											// Each sample needs a temperature and a pressure conversion
+#define MAGNETOMETER_PERIOD 100000
+#define GPS_PERIOD 200000												// NEO_6M_UBX_PERIOD
+#define LOG_PERIOD 50000
+#define SCHEDULER_STATS_PERIOD 60000000
+
 using namespace std;
 using namespace std::chrono;
 using namespace cv;
 
-struct Frame {
-	Mat frame;
-	unsigned int n;
-};
-
-void CaptureImages(VideoCapture*, vector<Frame>*, unsigned int*, unsigned int*);
-void RecordImages(vector<Frame>*);
-void RecordVideo(VideoWriter*, vector<Frame>*);
-void ReadSensors(BMP180*, HMC5883*, MPU6050*, NEO_6M*, Log*,
-				 uint16_t, vector<Frame>*, unsigned int*, unsigned int*);
-void ReadDMP(MPU6050*, uint16_t, SensorsData*);
+void CaptureImages(VideoCapture*, FrameRing*, SensorHub*);
+void RecordImages(FrameRing*, IMUStream*);
+void RecordVideo(VideoWriter*, FrameRing*);
+void ReadSensors(BMP180*, HMC5883*, MPU6050*, NEO_6M*, Log*, SensorHub*, IMUStream*, uint16_t);
+void ReadDMP(MPU6050*, uint16_t, IMUStream*, SensorsData*);
 
 auto datalog_start = high_resolution_clock::now();						// Reference time
-mutex mt;
 
 int main()
 {
@@ -73,9 +87,9 @@ int main()
 	#endif
 	Log log;
 	uint16_t packetSize;												// expected DMP packet size (default is 42 bytes)
-	vector<Frame> frames;
-	unsigned int frame_counter = 0;
-	unsigned int frame_capture_time = 0;
+	FrameRing frames(FRAME_RING_SIZE, FRAME_RING_POLICY);
+	SensorHub hub;
+	IMUStream imu_stream;												// Full rate attitude, for the frames
 	
 	// MPU6050 and its DMP initialization
 	imu.initialize();
@@ -102,23 +116,22 @@ int main()
 				   camCapture.get(CAP_PROP_FRAME_HEIGHT)), true);
 	#endif
 	
-	thread image_capture_thread(CaptureImages, &camCapture, &frames, 
-											   &frame_counter,
-											   &frame_capture_time);
-	thread image_record_thread(RecordImages, &frames);
+	thread image_capture_thread(CaptureImages, &camCapture, &frames, &hub);
 	
-	#ifdef VIDEO_OUTPUT
+	// The ring has a single consumer: the images or the video recorder
+	#ifndef VIDEO_OUTPUT
+	thread image_record_thread(RecordImages, &frames, &imu_stream);
+	#else
 	thread video_record_thread(RecordVideo, &camOutput, &frames);
 	#endif
 	
 	thread read_sensors_thread(ReadSensors, &bar, &mag, &imu, gps,
-											&log, packetSize, &frames,
-											&frame_counter,
-											&frame_capture_time);
+											&log, &hub, &imu_stream, packetSize);
 
 	image_capture_thread.join();
+	#ifndef VIDEO_OUTPUT
 	image_record_thread.join();
-	#ifdef VIDEO_OUTPUT
+	#else
 	video_record_thread.join();
 	#endif
 	read_sensors_thread.join();
@@ -132,29 +145,27 @@ int main()
 	return 0;
 }
 
-void CaptureImages(VideoCapture *camCapture, vector<Frame> *cap,
-				   unsigned int *frame_counter, unsigned int *frame_capture_time)
+void CaptureImages(VideoCapture *camCapture, FrameRing *cap, SensorHub *hub)
 {
 	unsigned int empty_frames = 0;
-	
-	Frame fr;
-	
-	fr.n = 0;
+	unsigned int n = 0;
 	
 	while(true)
 	{
-		camCapture->read(fr.frame);
+		// The frame is read straight into a buffer of the ring
+		Frame *fr = cap->getWriteFrame();
+		camCapture->read(fr->frame);
 		auto frame_capture_end = high_resolution_clock::now();
 		
-		if (!fr.frame.empty())
+		if (!fr->frame.empty())
 		{
-			mt.lock();	
-			cap->push_back(fr);
-			mt.lock();
+			fr->n = n++;
+			fr->time = duration_cast<milliseconds>(frame_capture_end - datalog_start).count();
+			fr->clock = MonotonicTime();
+			fr->sensors = hub->getSnapshot();							// Telemetry at the capture time
+			cap->Publish();
 			
-			*frame_counter = *frame_counter + 1;
-			fr.n++;
-			*frame_capture_time = duration_cast<milliseconds>(frame_capture_end - datalog_start).count();
+			hub->PublishFrame(n, fr->time);								// The log gets the number and the time together
 			
 			if (empty_frames > 0)
 				empty_frames = 0;
@@ -172,7 +183,7 @@ void CaptureImages(VideoCapture *camCapture, vector<Frame> *cap,
 	}
 }
 
-void RecordImages(vector<Frame> *cap)
+void RecordImages(FrameRing *cap, IMUStream *imu_stream)
 {	
 	string folder = "captures";
 	
@@ -184,172 +195,204 @@ void RecordImages(vector<Frame> *cap)
 	createDirectory(folder);
 	folder += "/";
 	
-	string file_name;
+	JpegPool pool(folder, imu_stream);
+	unsigned long dropped = 0;
+	auto stats_time = high_resolution_clock::now();
 	
 	while(true)
 	{
-		while(!cap->empty())
+		Frame *fr;
+		
+		while((fr = cap->Front()) != NULL)
 		{
-			ostringstream buffer;
-			
-			unsigned int frame_number = cap->front().n;
-	
-			buffer << cap->front().n;
-			file_name = folder;
-			
-			if (frame_number < 10)
-				file_name += "00000";
-			else if (frame_number < 100)
-				file_name += "0000";
-			else if (frame_number < 1000)
-				file_name += "000";
-			else if (frame_number < 10000)
-				file_name += "00";
-			else if (frame_number < 100000)
-				file_name += "0";
+			pool.Submit(fr);											// Waits if all the encoders are busy
 			
-			file_name += buffer.str();
-			file_name += ".jpg";
+			cap->Release();
+		}
+		
+		auto now = high_resolution_clock::now();
+		if ((cap->getDropped() != dropped) or (duration_cast<seconds>(now - stats_time).count() >= RECORD_STATS_PERIOD))
+		{
+			if (cap->getDropped() != dropped)
+			{
+				dropped = cap->getDropped();
+				cerr << "Warning: " << dropped << " of " << cap->getCaptured()
+					 << " frames were dropped (the recording is too slow)" << endl;
+			}
 			
-			imwrite(file_name, cap->front().frame);
+			cerr << "JPEG encoding: " << pool.getWorkers() << " workers, "
+				 << pool.getEncodeTime() << " ms (max " << pool.getMaxEncodeTime() << " ms), "
+				 << "queue depth " << pool.getQueueDepth() << " (max " << pool.getMaxQueueDepth()
+				 << ")" << endl;
 			
-			mt.lock();
-			cap->erase(cap->begin());
-			mt.unlock();
+			stats_time = now;
 		}
+		
+		cap->Wait(RECORD_WAIT_TIMEOUT);
 	}
 }
 
-void RecordVideo(VideoWriter* camOutput, vector<Frame> *cap)
+void RecordVideo(VideoWriter* camOutput, FrameRing *cap)
 {
 	while(true)
 	{
-		while(!cap->empty())
+		Frame *fr;
+		
+		while((fr = cap->Front()) != NULL)
 		{
-			camOutput->write(cap->front().frame);
+			camOutput->write(fr->frame);
 			
-			cap->erase(cap->begin());
+			cap->Release();
 		}
+		
+		cap->Wait();
 	}
 }
 
 void ReadSensors(BMP180 *bar, HMC5883 *mag, MPU6050 *imu, NEO_6M *gps,
-				 Log *log, uint16_t packetSize, vector<Frame> *cap,
-				 unsigned int *frame_counter, unsigned int *frame_capture_time)
+				 Log *log, SensorHub *hub, IMUStream *imu_stream, uint16_t packetSize)
 {
 	SensorsData sData;
+	Scheduler scheduler;
 	
-	int one_sec_counter = 0;
-	int hundred_ms_counter = 0;
+	memset(&sData, 0, sizeof(sData));
 	
-	while(true)
-	{	
-		// Get acc/gyro data
-		ReadDMP(imu, packetSize, &sData);
-		
-		// Get barometer pressure and altitude
-		bar->Read();
-		sData.pressure = bar->getPressure();
-		sData.altitude = bar->getAltitude();
-		
-		if (hundred_ms_counter == 2)									// 100 ms timer
-		{
-			// Get magnetometer data
-			mag->Read();
-			sData.mag_x = mag->getXMagData();
-			sData.mag_y = mag->getYMagData();
-			sData.mag_z = mag->getZMagData();
-			sData.heading = mag->getHeading();
-			
-			hundred_ms_counter = 0;
-		}
-		
-		if (one_sec_counter == 20)										// 1 second timer (Sample rate = 1 Hz)
+	// Get acc/gyro data (every DMP packet, in bursts)
+	scheduler.AddTask("imu", IMU_PERIOD, [&]() {
+		ReadDMP(imu, packetSize, imu_stream, &sData);
+		hub->Publish(sData);											// Each read is published to the other threads
+	});
+	
+	// Get barometer temperature, pressure and altitude (the conversions go on between the releases)
+	scheduler.AddTask("barometer", BAROMETER_PERIOD, [&]() {
+		if (bar->Update())
 		{
-			// Get barometer temperature
 			sData.temperature = bar->getTemperature();
-			
-			// Get GPS data
-			gps->Read();
-			sData.latitude = gps->getData().location.lat();
-			sData.longitude = gps->getData().location.lng();
-			sData.gps_altitude = gps->getData().altitude.meters();
-			sData.course = gps->getData().course.deg();
-			sData.speed = gps->getData().speed.kmph();
-			sData.centisecond = gps->getData().time.centisecond();
-			sData.second = gps->getData().time.second();
-			sData.minute = gps->getData().time.minute();
-			sData.hour = gps->getData().time.hour();
-			sData.day = gps->getData().date.day();
-			sData.month = gps->getData().date.month();
-			sData.year = gps->getData().date.year();
-			sData.satellites = gps->getData().satellites.value();
-			sData.hdop = gps->getData().hdop.value();
-			
-			one_sec_counter = 0;
+			sData.pressure = bar->getPressure();
+			sData.altitude = bar->getAltitude();
+			hub->Publish(sData);
 		}
-		
-		log->Write(*frame_counter, *frame_capture_time, &sData);
-		
-		usleep(50000);
-		
-		one_sec_counter++;
-		hundred_ms_counter++;
-	}
+	});
+	
+	// Get magnetometer data
+	scheduler.AddTask("magnetometer", MAGNETOMETER_PERIOD, [&]() {
+		mag->Read();
+		sData.mag_x = mag->getXMagData();
+		sData.mag_y = mag->getYMagData();
+		sData.mag_z = mag->getZMagData();
+		sData.heading = mag->getHeading();
+		hub->Publish(sData);
+	});
+	
+	// Get GPS data (decoded by the NEO_6M thread)
+	scheduler.AddTask("gps", GPS_PERIOD, [&]() {
+		GpsFix fix = gps->getFix();
+		sData.latitude = fix.latitude;
+		sData.longitude = fix.longitude;
+		sData.gps_altitude = fix.altitude;
+		sData.course = fix.course;
+		sData.speed = fix.speed;
+		sData.centisecond = fix.centisecond;
+		sData.second = fix.second;
+		sData.minute = fix.minute;
+		sData.hour = fix.hour;
+		sData.day = fix.day;
+		sData.month = fix.month;
+		sData.year = fix.year;
+		sData.satellites = fix.satellites;
+		sData.hdop = fix.hdop;
+		hub->Publish(sData);
+	});
+	
+	scheduler.AddTask("log", LOG_PERIOD, [&]() {
+		FrameStamp frame = hub->getFrame();
+		log->Write(frame.n, frame.time, &sData);
+	});
+	
+	// Overruns of each task, once in a while
+	scheduler.AddTask("stats", SCHEDULER_STATS_PERIOD, [&]() {
+		scheduler.PrintStats(cerr);
+		if (imu_stream->getOverflows() > 0)
+			cerr << "Warning: the IMU FIFO overflowed " << imu_stream->getOverflows() << " times" << endl;
+	}, SCHEDULER_STATS_PERIOD);
+	
+	scheduler.Run();
 }
 
-// Read MPU6050 DMP data
-void ReadDMP(MPU6050 *imu, uint16_t packetSize, SensorsData *sData)
+// Read all the complete MPU6050 DMP packets of the FIFO
+void ReadDMP(MPU6050 *imu, uint16_t packetSize, IMUStream *stream, SensorsData *sData)
 {
-	uint8_t fifoBuffer[64];												// FIFO storage buffer
+	uint8_t fifoBuffer[DMP_BURST_PACKETS*64];							// FIFO storage buffer
 	
 	Quaternion q;														// [w, x, y, z] quaternion container
 	VectorFloat gravity;												// [x, y, z] gravity vector
-	float ypr[3];														// [yaw, pitch, roll] yaw/pitch/roll container and gravity vector
-	float euler[3];
-
-	int16_t accel[3];
-	int16_t gyro[3];
-
+	
 	uint16_t fifoCount = imu->getFIFOCount();							// count of all bytes currently in FIFO
-	if (fifoCount == 1024)
+	uint64_t read_time = MonotonicTime();
+	
+	if (fifoCount >= 1024)
 	{
 		imu->resetFIFO();												// reset so we can continue cleanly
-		sData->ax = sData->ay = sData->az = 0;
-		sData->gx = sData->gy = sData->gz = 0;
-		sData->yaw = sData->pitch = sData->roll = 0;
+		stream->AddOverflow();
+		return;
 	}
-	else if (fifoCount >= 42)											// otherwise, check for DMP data ready interrupt (this should happen frequently)
+	
+	// The newest packet is taken as produced at the read time, and each
+	// older one a DMP period before
+	unsigned int packets = fifoCount/packetSize;
+	for(unsigned int i=0;i<packets;)
 	{
-        imu->getFIFOBytes(fifoBuffer, packetSize);						// read a packet from FIFO
-        imu->dmpGetAccel(accel, fifoBuffer);
-        imu->dmpGetGyro(gyro, fifoBuffer);
-		imu->dmpGetQuaternion(&q, fifoBuffer);
-		imu->dmpGetGravity(&gravity, &q);
-		imu->dmpGetEuler(euler, &q);
-		imu->dmpGetYawPitchRoll(ypr, &q, &gravity);
+		unsigned int burst = packets - i;
+		if (burst > DMP_BURST_PACKETS)
+			burst = DMP_BURST_PACKETS;
+		if (burst*packetSize > 255)										// getFIFOBytes() length is 8 bits
+			burst = 255/packetSize;
+		
+		imu->getFIFOBytes(fifoBuffer, burst*packetSize);				// read up to DMP_BURST_PACKETS packets at once
 		
-		sData->ax = accel[0];
-		sData->ay = accel[1];
-		sData->az = accel[2];
-		sData->gx = gyro[0];
-		sData->gy = gyro[1];
-		sData->gz = gyro[2];
-		sData->qw = q.w;
-		sData->qx = q.x;
-		sData->qy = q.y;
-		sData->qz = q.z;
-		sData->euler_yaw = euler[0];
-		sData->euler_pitch = euler[1];
-		sData->euler_roll = euler[2];
-		sData->yaw = ypr[0] * 180/M_PI;									// Conversion from radians to degrees
-		sData->pitch = ypr[1] * 180/M_PI;
-		sData->roll = ypr[2] * 180/M_PI;
+		for(unsigned int j=0;j<burst;j++, i++)
+		{
+			uint8_t *packet = fifoBuffer + j*packetSize;
+			IMUSample sample;
+			
+			sample.time = read_time - uint64_t(packets - 1 - i)*DMP_PACKET_PERIOD;
+			imu->dmpGetAccel(sample.accel, packet);
+			imu->dmpGetGyro(sample.gyro, packet);
+			imu->dmpGetQuaternion(&q, packet);
+			imu->dmpGetGravity(&gravity, &q);
+			imu->dmpGetEuler(sample.euler, &q);
+			imu->dmpGetYawPitchRoll(sample.ypr, &q, &gravity);
+			
+			sample.q[0] = q.w;
+			sample.q[1] = q.x;
+			sample.q[2] = q.y;
+			sample.q[3] = q.z;
+			for(int k=0;k<3;k++)
+				sample.ypr[k] *= 180/M_PI;								// Conversion from radians to degrees
+			
+			stream->Push(sample);
+		}
 	}
-	else
+	
+	// The log keeps the newest attitude
+	IMUSample sample;
+	if (stream->getLatest(&sample))
 	{
-		sData->ax = sData->ay = sData->az = 0;
-		sData->gx = sData->gy = sData->gz = 0;
-		sData->yaw = sData->pitch = sData->roll = 0;
+		sData->ax = sample.accel[0];
+		sData->ay = sample.accel[1];
+		sData->az = sample.accel[2];
+		sData->gx = sample.gyro[0];
+		sData->gy = sample.gyro[1];
+		sData->gz = sample.gyro[2];
+		sData->qw = sample.q[0];
+		sData->qx = sample.q[1];
+		sData->qy = sample.q[2];
+		sData->qz = sample.q[3];
+		sData->euler_yaw = sample.euler[0];
+		sData->euler_pitch = sample.euler[1];
+		sData->euler_roll = sample.euler[2];
+		sData->yaw = sample.ypr[0];
+		sData->pitch = sample.ypr[1];
+		sData->roll = sample.ypr[2];
 	}
 }
@@ -0,0 +1,473 @@
+/*
+ * Traffic Management UAV Data Capture.
+ * A program to capture images and sensors data with Raspberry Pi.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+/*
+ * NEO_6M driver test against a simulated receiver.
+ * 
+ * The receiver is the master side of a pseudo-terminal: the driver opens
+ * the slave side as its serial device, and the test writes canned NMEA
+ * sentences and UBX frames to the master and checks the fixes published by
+ * getFix() and the UBX parser counters. The UBX configuration written by
+ * the driver is read back from the master.
+ */
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <cstring>
+#include <cstdlib>
+#include <stdexcept>
+#include <cmath>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../include/neo-6m.h"
+#include "../include/ubx.h"
+#include "../include/scheduler.h"										// MonotonicTime()
+
+#define FIX_TIMEOUT 1000000000ULL										// ns to wait for a fix
+#define CONFIG_FRAMES 12												// CFG-MSG of 11 messages and CFG-RATE
+
+#define CHECK(c) Check((c), #c, __LINE__)
+
+using namespace std;
+
+// Dublin, 28/05/2011 09:27:50 UTC
+const char GGA[] = "$GPGGA,092750.000,5321.6802,N,00630.3372,W,1,8,1.03,61.7,M,55.2,M,,*76\r\n";
+const char RMC[] = "$GPRMC,092750.000,A,5321.6802,N,00630.3372,W,0.02,31.66,280511,,,A*43\r\n";
+
+int failures = 0;
+
+void Check(bool c, const char *expr, int line)
+{
+	if (!c)
+	{
+		cerr << "neo-6m-test.cpp:" << line << ": check failed: " << expr << endl;
+		failures++;
+	}
+}
+
+// Simulated receiver (master side of a pty)
+class Receiver {
+		int fd;
+		string device;
+	public:
+		Receiver()
+		{
+			if ((fd = posix_openpt(O_RDWR | O_NOCTTY)) < 0)
+				throw runtime_error("Error opening the pseudo-terminal!");
+			if ((grantpt(fd) < 0) or (unlockpt(fd) < 0))
+				throw runtime_error("Error unlocking the pseudo-terminal!");
+			device = ptsname(fd);
+		}
+		
+		~Receiver()
+		{
+			close(fd);
+		}
+		
+		const char* getDevice()
+		{
+			return device.c_str();
+		}
+		
+		void Send(const void *data, size_t length)
+		{
+			if (write(fd, data, length) != (ssize_t)length)
+				throw runtime_error("Error writing to the pseudo-terminal!");
+		}
+		
+		void Send(const char *s)
+		{
+			this->Send(s, strlen(s));
+		}
+		
+		void Send(const vector<uint8_t> &data)
+		{
+			this->Send(data.data(), data.size());
+		}
+		
+		// Reads what the driver wrote, until nothing arrives for 100 ms
+		vector<uint8_t> Receive()
+		{
+			vector<uint8_t> data;
+			uint8_t buffer[256];
+			uint64_t last = MonotonicTime();
+			
+			fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+			while(MonotonicTime() - last < 100000000)
+			{
+				ssize_t n = read(fd, buffer, sizeof(buffer));
+				if (n > 0)
+				{
+					data.insert(data.end(), buffer, buffer + n);
+					last = MonotonicTime();
+				}
+				else
+					usleep(1000);
+			}
+			
+			return data;
+		}
+};
+
+// Canned navigation solution
+struct Solution {
+	uint32_t itow;														// GPS time of week (ms)
+	int32_t latitude;													// 1e-7 deg
+	int32_t longitude;
+	int32_t altitude;													// mm
+	uint32_t speed;														// cm/s
+	int32_t course;														// 1e-5 deg
+	int32_t nano;														// ns of the second
+};
+
+void PutU2(uint8_t *p, uint16_t v)
+{
+	p[0] = v & 0xFF;
+	p[1] = v >> 8;
+}
+
+void PutU4(uint8_t *p, uint32_t v)
+{
+	for(int i=0;i<4;i++)
+		p[i] = (v >> 8*i) & 0xFF;
+}
+
+void AddFrame(vector<uint8_t> &data, uint8_t id, const uint8_t *payload, uint16_t length)
+{
+	vector<uint8_t> frame;
+	
+	UBX_Frame(UBX_NAV, id, payload, length, frame);
+	data.insert(data.end(), frame.begin(), frame.end());
+}
+
+vector<uint8_t> POSLLH(const Solution &s)
+{
+	vector<uint8_t> data;
+	uint8_t p[28] = {0};
+	
+	PutU4(p, s.itow);
+	PutU4(p + 4, s.longitude);
+	PutU4(p + 8, s.latitude);
+	PutU4(p + 12, s.altitude + 55200);									// Above the ellipsoid
+	PutU4(p + 16, s.altitude);
+	AddFrame(data, UBX_NAV_POSLLH, p, sizeof(p));
+	
+	return data;
+}
+
+vector<uint8_t> VELNED(const Solution &s)
+{
+	vector<uint8_t> data;
+	uint8_t p[36] = {0};
+	
+	PutU4(p, s.itow);
+	PutU4(p + 20, s.speed);
+	PutU4(p + 24, s.course);
+	AddFrame(data, UBX_NAV_VELNED, p, sizeof(p));
+	
+	return data;
+}
+
+// 17/10/2026 12:34:56 UTC
+vector<uint8_t> TIMEUTC(const Solution &s)
+{
+	vector<uint8_t> data;
+	uint8_t p[20] = {0};
+	
+	PutU4(p, s.itow);
+	PutU4(p + 8, s.nano);
+	PutU2(p + 12, 2026);
+	p[14] = 10;
+	p[15] = 17;
+	p[16] = 12;
+	p[17] = 34;
+	p[18] = 56;
+	p[19] = 0x07;														// UTC valid
+	AddFrame(data, UBX_NAV_TIMEUTC, p, sizeof(p));
+	
+	return data;
+}
+
+// 3D fix with 9 satellites, HDOP 0.87
+vector<uint8_t> SOL_DOP(const Solution &s)
+{
+	vector<uint8_t> data;
+	uint8_t sol[52] = {0};
+	uint8_t dop[18] = {0};
+	
+	PutU4(sol, s.itow);
+	sol[10] = 3;
+	sol[11] = 0x01;
+	sol[47] = 9;
+	AddFrame(data, UBX_NAV_SOL, sol, sizeof(sol));
+	
+	PutU4(dop, s.itow);
+	PutU2(dop + 12, 87);
+	AddFrame(data, UBX_NAV_DOP, dop, sizeof(dop));
+	
+	return data;
+}
+
+// Newer receivers: the whole solution in one message (3D fix, 11 satellites,
+// PDOP 1.20)
+vector<uint8_t> PVT(const Solution &s)
+{
+	vector<uint8_t> data;
+	uint8_t p[92] = {0};
+	
+	PutU4(p, s.itow);
+	PutU2(p + 4, 2026);
+	p[6] = 10;
+	p[7] = 17;
+	p[8] = 12;
+	p[9] = 34;
+	p[10] = 57;
+	p[11] = 0x07;														// Date and time valid
+	PutU4(p + 16, s.nano);
+	p[20] = 3;
+	p[21] = 0x01;
+	p[23] = 11;
+	PutU4(p + 24, s.longitude);
+	PutU4(p + 28, s.latitude);
+	PutU4(p + 32, s.altitude + 55200);
+	PutU4(p + 36, s.altitude);
+	PutU4(p + 60, s.speed*10);											// mm/s
+	PutU4(p + 64, s.course);
+	PutU2(p + 76, 120);
+	AddFrame(data, UBX_NAV_PVT, p, sizeof(p));
+	
+	return data;
+}
+
+// Waits until the driver thread meets the condition, at most FIX_TIMEOUT
+bool WaitFor(function<bool()> done)
+{
+	uint64_t start = MonotonicTime();
+	
+	while(!done())
+	{
+		if (MonotonicTime() - start >= FIX_TIMEOUT)
+			return false;
+		usleep(1000);
+	}
+	
+	return true;
+}
+
+// Waits for a fix decoded after the given number of sentences (or frames)
+GpsFix WaitFix(NEO_6M &gps, uint32_t sentences)
+{
+	WaitFor([&]() { return gps.getFix().sentences >= sentences; });
+	
+	return gps.getFix();
+}
+
+void TestNMEA()
+{
+	Receiver rx;
+	NEO_6M gps(rx.getDevice(), NEO_6M_NMEA);
+	
+	GpsFix f = gps.getFix();
+	CHECK(!f.valid);
+	CHECK(f.sentences == 0);
+	CHECK(gps.getFixAge() == UINT32_MAX);
+	
+	// The sentences are split across the reads
+	string s = string(GGA) + RMC;
+	rx.Send(s.data(), 20);
+	usleep(5000);
+	rx.Send(s.data() + 20, s.size() - 20);
+	
+	f = WaitFix(gps, 2);
+	CHECK(f.sentences == 2);
+	CHECK(f.valid);
+	CHECK(f.protocol == NEO_6M_NMEA);
+	CHECK(fabs(f.latitude - 53.361337) < 1e-6);
+	CHECK(fabs(f.longitude + 6.50562) < 1e-6);
+	CHECK(fabs(f.altitude - 61.7) < 1e-6);
+	CHECK(fabs(f.course - 31.66) < 1e-6);
+	CHECK(f.satellites == 8);
+	CHECK(f.hdop == 103);
+	CHECK((f.hour == 9) and (f.minute == 27) and (f.second == 50));
+	CHECK((f.day == 28) and (f.month == 5) and (f.year == 2011));
+	CHECK(gps.getFixAge() < 1000);
+	
+	// A sentence with a bad checksum is not decoded
+	string bad = GGA;
+	bad[bad.size() - 4] = '0';
+	rx.Send(bad.c_str());
+	rx.Send(RMC);
+	
+	f = WaitFix(gps, 3);
+	CHECK(f.sentences == 3);
+	usleep(20000);
+	CHECK(gps.getFix().sentences == 3);
+}
+
+void TestUBXConfiguration(Receiver &rx)
+{
+	vector<uint8_t> config = rx.Receive();
+	UBXParser parser;
+	int frames = 0;
+	
+	for(unsigned int i=0;i<config.size();i++)
+	{
+		if (parser.Parse(config[i]) != UBX_FRAME)
+			continue;
+		frames++;
+		
+		const uint8_t *p = parser.getPayload();
+		CHECK(parser.getClass() == UBX_CFG);
+		if (parser.getId() == UBX_CFG_RATE)
+			CHECK(UBX_U2(p) == NEO_6M_UBX_PERIOD);
+		else if ((p[0] == UBX_NAV) and ((p[1] == UBX_NAV_POSLLH) or (p[1] == UBX_NAV_VELNED) or (p[1] == UBX_NAV_TIMEUTC)))
+			CHECK(p[2] == 1);											// Every solution
+		else if ((p[0] == NMEA_CLASS) and ((p[1] == NMEA_GGA) or (p[1] == NMEA_RMC)))
+			CHECK(p[2] == 1000/NEO_6M_UBX_PERIOD);						// 1 Hz
+		else if (p[0] == NMEA_CLASS)
+			CHECK(p[2] == 0);
+	}
+	
+	CHECK(frames == CONFIG_FRAMES);
+	CHECK(parser.getFailedChecksum() == 0);
+}
+
+void TestUBX()
+{
+	Receiver rx;
+	NEO_6M gps(rx.getDevice(), NEO_6M_UBX);
+	
+	TestUBXConfiguration(rx);
+	
+	// A complete solution
+	Solution s1 = {1000, 533613370, -65056200, 61700, 1000, 9012345, 200000000};
+	vector<uint8_t> data = SOL_DOP(s1);
+	vector<uint8_t> m = POSLLH(s1);
+	data.insert(data.end(), m.begin(), m.end());
+	m = VELNED(s1);
+	data.insert(data.end(), m.begin(), m.end());
+	m = TIMEUTC(s1);
+	data.insert(data.end(), m.begin(), m.end());
+	rx.Send(data);
+	
+	GpsFix f = WaitFix(gps, 5);
+	CHECK(f.sentences == 5);
+	CHECK(f.protocol == NEO_6M_UBX);
+	CHECK(f.valid);
+	CHECK(fabs(f.latitude - 53.361337) < 1e-7);
+	CHECK(fabs(f.longitude + 6.50562) < 1e-7);
+	CHECK(fabs(f.altitude - 61.7) < 1e-9);
+	CHECK(fabs(f.speed - 36.0) < 1e-9);
+	CHECK(fabs(f.course - 90.12345) < 1e-9);
+	CHECK(f.satellites == 9);
+	CHECK(f.hdop == 87);
+	CHECK((f.hour == 12) and (f.minute == 34) and (f.second == 56) and (f.centisecond == 20));
+	CHECK((f.day == 17) and (f.month == 10) and (f.year == 2026));
+	CHECK(gps.getUBXFrames() == 5);
+	CHECK(gps.getUBXFailures() == 0);
+	
+	// The next one with a corrupted POSLLH: the solution is incomplete
+	Solution s2 = {1200, 533613470, -65056100, 61800, 1200, 9112345, 400000000};
+	data = POSLLH(s2);
+	data[10] ^= 0x01;
+	m = VELNED(s2);
+	data.insert(data.end(), m.begin(), m.end());
+	m = TIMEUTC(s2);
+	data.insert(data.end(), m.begin(), m.end());
+	rx.Send(data);
+	
+	CHECK(WaitFor([&]() { return gps.getUBXFrames() == 7; }));
+	CHECK(gps.getUBXFailures() == 1);
+	f = gps.getFix();
+	CHECK(f.sentences == 5);
+	CHECK(fabs(f.latitude - 53.361337) < 1e-7);
+	
+	// Its POSLLH again completes it
+	rx.Send(POSLLH(s2));
+	f = WaitFix(gps, 8);
+	CHECK(f.sentences == 8);
+	CHECK(f.protocol == NEO_6M_UBX);
+	CHECK(fabs(f.latitude - 53.361347) < 1e-7);
+	CHECK(fabs(f.course - 91.12345) < 1e-9);
+	CHECK(f.centisecond == 40);
+	
+	// A NAV-PVT is a solution by itself
+	Solution s3 = {1400, 533613570, -65056000, 61900, 1400, 9212345, 600000000};
+	rx.Send(PVT(s3));
+	f = WaitFix(gps, 9);
+	CHECK(f.sentences == 9);
+	CHECK(f.protocol == NEO_6M_UBX);
+	CHECK(f.valid);
+	CHECK(fabs(f.latitude - 53.361357) < 1e-7);
+	CHECK(fabs(f.longitude + 6.5056) < 1e-7);
+	CHECK(fabs(f.altitude - 61.9) < 1e-9);
+	CHECK(fabs(f.speed - 50.4) < 1e-9);
+	CHECK(fabs(f.course - 92.12345) < 1e-9);
+	CHECK(f.satellites == 11);
+	CHECK(f.hdop == 87);												// NAV-DOP already received
+	CHECK((f.second == 57) and (f.centisecond == 60));
+	
+	// The NMEA sentences are not used while the UBX solutions arrive
+	rx.Send(GGA);
+	rx.Send(RMC);
+	usleep(50000);
+	f = gps.getFix();
+	CHECK(f.protocol == NEO_6M_UBX);
+	CHECK(f.sentences == 9);
+	
+	// but they are without UBX solutions for NEO_6M_UBX_TIMEOUT
+	usleep(NEO_6M_UBX_TIMEOUT/1000 + 100000);
+	rx.Send(GGA);
+	rx.Send(RMC);
+	CHECK(WaitFor([&]() { return gps.getFix().protocol == NEO_6M_NMEA; }));
+	f = gps.getFix();
+	CHECK(fabs(f.latitude - 53.3613367) < 1e-6);
+	CHECK(f.satellites == 8);
+	CHECK(gps.getUBXFrames() == 9);
+	CHECK(gps.getUBXFailures() == 1);
+}
+
+int main()
+{
+	try
+	{
+		TestNMEA();
+		TestUBX();
+	}
+	catch(exception &e)
+	{
+		cerr << e.what() << endl;
+		return 1;
+	}
+	
+	if (failures > 0)
+	{
+		cerr << failures << " checks failed" << endl;
+		return 1;
+	}
+	
+	cout << "All the NEO_6M checks passed" << endl;
+	
+	return 0;
+}
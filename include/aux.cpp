@@ -31,8 +31,8 @@ void Setup(Config &config, Mat frame)
 {
     config.sliding_window_width = 50;
     config.sliding_window_height = 25;
-    config.sliding_window_horizontal_step = 6;
-    config.sliding_window_vertical_step = 6;
+    config.sliding_window_horizontal_step = 5;                          // Multiple of the HOG cell size
+    config.sliding_window_vertical_step = 5;
     config.pyramid_initial_scale = 1;
     config.pyramid_final_scale = 1;
     config.pyramid_scale_step = 0.5;
@@ -57,6 +57,7 @@ void Setup(Config &config, Mat frame)
     
     config.of_subPixWinSize = Size(10,10);
     config.of_winSize = Size(31,31);
+    config.of_max_level = 3;
     config.of_termcrit = TermCriteria(TermCriteria::COUNT|TermCriteria::EPS, 20, 0.03);
     
     config.still_flight_threshold = 0.1;
@@ -108,22 +109,22 @@ void ReadSensors(SensorsData &sensors_data)
 	sensors_data.hdop = 9999;
 }
 
-Mat DrawResults(Mat image, vector<Car> &cars, BGTracking &nav, SensorsData &sensors_data, Config &config)
+Mat DrawResults(Mat image, TrackTable &cars, BGTracking &nav, SensorsData &sensors_data, Config &config)
 {
     // Draw cars bounding boxes and speed
-    for(unsigned int i=0;i<cars.size();i++)
+    for(int i=0;i<cars.getSize();i++)
     {
         ostringstream buffer;
-        if (cars[i].getSpeed() >= 100)
-            buffer << trunc(cars[i].getSpeed());
-        else if (cars[i].getSpeed() >= 10)
-            buffer << trunc(cars[i].getSpeed()*10)/10;
+        if (cars.getSpeed(i) >= 100)
+            buffer << trunc(cars.getSpeed(i));
+        else if (cars.getSpeed(i) >= 10)
+            buffer << trunc(cars.getSpeed(i)*10)/10;
         else
-            buffer << trunc(cars[i].getSpeed()*100)/100;
-        rectangle(image, cars[i].getRect(), config.cars_rect_color, 2);
-        rectangle(image, Rect(cars[i].getRect().x, cars[i].getRect().y-15, 35, 15), Scalar(255,0,0), CV_FILLED);
+            buffer << trunc(cars.getSpeed(i)*100)/100;
+        rectangle(image, cars.getRect(i), config.cars_rect_color, 2);
+        rectangle(image, Rect(cars.getRect(i).x, cars.getRect(i).y-15, 35, 15), Scalar(255,0,0), CV_FILLED);
         putText(image, buffer.str(),
-                Point2f(cars[i].getRect().x+2, cars[i].getRect().y-4), config.cars_speed_font,
+                Point2f(cars.getRect(i).x+2, cars.getRect(i).y-4), config.cars_speed_font,
                 config.cars_speed_font_size,
                 config.cars_speed_font_color);
     }
@@ -175,11 +176,11 @@ Mat DrawROIs(Mat image, vector<Rect> rois)
     return image;
 }
 
-Mat DrawCarsKeyPoints(Mat image, vector<Car> cars, Scalar color)
+Mat DrawCarsKeyPoints(Mat image, TrackTable &cars, Scalar color)
 {
-    for(unsigned int i=0;i<cars.size();i++)
-        for(unsigned int j=0;j<cars[i].getKeyPoints().size();j++)
-        circle(image, cars[i].getKeyPoints()[j], 3, color, -1, 5);
+    for(int i=0;i<cars.getSize();i++)
+        for(int j=0;j<CAR_KEYPOINTS;j++)
+        circle(image, cars.getKeyPoints(i)[j], 3, color, -1, 5);
     
     return image;
 }
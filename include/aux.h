@@ -24,7 +24,7 @@
 #include <vector>
 #include <opencv2/opencv.hpp>
 
-#include "car.h"
+#include "tracks.h"
 #include "bgtracking.h"
 #include "config.h"
 #include "sensors_data.h"
@@ -33,7 +33,7 @@ void Setup(Config&, cv::Mat);
 
 void ReadSensors(SensorsData&);
 
-cv::Mat DrawResults(cv::Mat, std::vector<Car>&, BGTracking&, SensorsData&, Config&);
+cv::Mat DrawResults(cv::Mat, TrackTable&, BGTracking&, SensorsData&, Config&);
 
 cv::Mat DrawKeyPoints(cv::Mat, std::vector<cv::Point2f>, cv::Scalar);
 
@@ -41,7 +41,7 @@ cv::Mat WriteFPS(cv::Mat, double);
 
 cv::Mat DrawROIs(cv::Mat, std::vector<cv::Rect>);
 
-cv::Mat DrawCarsKeyPoints(cv::Mat, std::vector<Car>, cv::Scalar);
+cv::Mat DrawCarsKeyPoints(cv::Mat, TrackTable&, cv::Scalar);
 
 std::vector<cv::Point2f> KeyPoint2Point2f(std::vector<cv::KeyPoint>);
 
@@ -19,6 +19,7 @@
  */
 
 #include <cmath>
+#include <algorithm>
 
 #include "bgtracking.h"
 
@@ -42,7 +43,7 @@ void BGTracking::setKeyPoints(vector<Point2f> points)
     prev_bg_keypoints = points;
 }
 
-vector<Point2f> BGTracking::getKeyPoints()
+const vector<Point2f>& BGTracking::getKeyPoints()
 {
     return prev_bg_keypoints;
 }
@@ -57,20 +58,25 @@ double BGTracking::getAngle()
     return angle;
 }
 
-bool BGTracking::Update(Mat &prev_frame, Mat &frame, Mat &f, bool draw_of_vectors)
+bool BGTracking::Update(FramePyramid &prev_frame, FramePyramid &frame, Mat &f, bool draw_of_vectors)
 {
     vector<float> err;
     vector<uchar> status;
     vector<Point2f> new_bg_keypoints = prev_bg_keypoints;
-    calcOpticalFlowPyrLK(prev_frame, frame, prev_bg_keypoints,
+    calcOpticalFlowPyrLK(prev_frame.getOFPyramid(), frame.getOFPyramid(), prev_bg_keypoints,
                          new_bg_keypoints, status, err,
-                         config->of_winSize, 3, config->of_termcrit, 0,
-                         0.001);
+                         config->of_winSize, min(prev_frame.getOFLevels(), frame.getOFLevels()),
+                         config->of_termcrit, 0, 0.001);
     
+    return this->Update(new_bg_keypoints.data(), status.data(), f, draw_of_vectors);
+}
+
+bool BGTracking::Update(const Point2f *new_bg_keypoints, const uchar *status, Mat &f, bool draw_of_vectors)
+{
     modulus = 0;
     angle = 0;
     int counter = 0;
-    for(unsigned int i=0;i<status.size();i++)
+    for(unsigned int i=0;i<prev_bg_keypoints.size();i++)
     {
         if (status[i])                                                  // Check if the optical flow between the keypoints was found
         {
@@ -94,7 +100,7 @@ bool BGTracking::Update(Mat &prev_frame, Mat &frame, Mat &f, bool draw_of_vector
         angle /= counter;
     }
     
-    prev_bg_keypoints = new_bg_keypoints;
+    prev_bg_keypoints.assign(new_bg_keypoints, new_bg_keypoints + prev_bg_keypoints.size());
     
     if (counter < 50)
     {
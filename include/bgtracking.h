@@ -25,6 +25,7 @@
 #include <opencv2/opencv.hpp>
 
 #include "config.h"
+#include "pyramid.h"
 
 class BGTracking
 {
@@ -38,10 +39,11 @@ class BGTracking
         BGTracking(std::vector<cv::Point2f>, Config&);
         ~BGTracking();
         void setKeyPoints(std::vector<cv::Point2f>);
-        std::vector<cv::Point2f> getKeyPoints();
+        const std::vector<cv::Point2f>& getKeyPoints();
         double getModulus();
         double getAngle();
-        bool Update(cv::Mat&, cv::Mat&, cv::Mat&, bool);
+        bool Update(FramePyramid&, FramePyramid&, cv::Mat&, bool);
+        bool Update(const cv::Point2f*, const uchar*, cv::Mat&, bool);
 };
 
 #endif
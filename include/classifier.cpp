@@ -0,0 +1,179 @@
+/*
+ * Traffic Management UAV.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#include <stdexcept>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+#include "classifier.h"
+
+using namespace std;
+using namespace cv;
+using namespace cv::ml;
+
+#if defined(__AVX2__)
+static inline float HorizontalSum(__m256 v)
+{
+    __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+
+static inline __m256 MulAdd(__m256 a, __m256 b, __m256 c)
+{
+#if defined(__FMA__)
+    return _mm256_fmadd_ps(a, b, c);
+#else
+    return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+}
+#elif defined(__SSE2__)
+static inline float HorizontalSum(__m128 s)
+{
+    s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+    s = _mm_add_ss(s, _mm_shuffle_ps(s, s, 1));
+    return _mm_cvtss_f32(s);
+}
+#endif
+
+// Dot products of the weights with up to four descriptors, sharing the weight loads
+static void Dot4(const float *w, const float *x, int size, int count, float *result)
+{
+    const float *x0 = x;
+    const float *x1 = (count > 1)? x + size:x0;
+    const float *x2 = (count > 2)? x + 2*size:x0;
+    const float *x3 = (count > 3)? x + 3*size:x0;
+    int i = 0;
+    float s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+
+#if defined(__AVX2__)
+    __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps();
+    __m256 a2 = _mm256_setzero_ps(), a3 = _mm256_setzero_ps();
+    for(;i+8<=size;i+=8)
+    {
+        __m256 wv = _mm256_loadu_ps(w + i);
+        a0 = MulAdd(wv, _mm256_loadu_ps(x0 + i), a0);
+        a1 = MulAdd(wv, _mm256_loadu_ps(x1 + i), a1);
+        a2 = MulAdd(wv, _mm256_loadu_ps(x2 + i), a2);
+        a3 = MulAdd(wv, _mm256_loadu_ps(x3 + i), a3);
+    }
+    s0 = HorizontalSum(a0);
+    s1 = HorizontalSum(a1);
+    s2 = HorizontalSum(a2);
+    s3 = HorizontalSum(a3);
+#elif defined(__SSE2__)
+    __m128 a0 = _mm_setzero_ps(), a1 = _mm_setzero_ps();
+    __m128 a2 = _mm_setzero_ps(), a3 = _mm_setzero_ps();
+    for(;i+4<=size;i+=4)
+    {
+        __m128 wv = _mm_loadu_ps(w + i);
+        a0 = _mm_add_ps(a0, _mm_mul_ps(wv, _mm_loadu_ps(x0 + i)));
+        a1 = _mm_add_ps(a1, _mm_mul_ps(wv, _mm_loadu_ps(x1 + i)));
+        a2 = _mm_add_ps(a2, _mm_mul_ps(wv, _mm_loadu_ps(x2 + i)));
+        a3 = _mm_add_ps(a3, _mm_mul_ps(wv, _mm_loadu_ps(x3 + i)));
+    }
+    s0 = HorizontalSum(a0);
+    s1 = HorizontalSum(a1);
+    s2 = HorizontalSum(a2);
+    s3 = HorizontalSum(a3);
+#endif
+
+    for(;i<size;i++)                                                    // Scalar tail (or the whole vector without SIMD)
+    {
+        s0 += w[i]*x0[i];
+        s1 += w[i]*x1[i];
+        s2 += w[i]*x2[i];
+        s3 += w[i]*x3[i];
+    }
+
+    result[0] = s0;
+    if (count > 1)
+        result[1] = s1;
+    if (count > 2)
+        result[2] = s2;
+    if (count > 3)
+        result[3] = s3;
+}
+
+LinearCarClassifier::LinearCarClassifier(Ptr<SVM> s)
+{
+    svm = s;
+
+    if (svm.empty() or (svm->getKernelType() != SVM::LINEAR))
+        throw runtime_error("The car classifier needs a trained linear SVM!");
+
+    // w = sum(alpha_i*sv_i), b = -rho
+    Mat support_vectors = svm->getSupportVectors();
+    Mat alpha;
+    Mat sv_idx;
+    double rho = svm->getDecisionFunction(0, alpha, sv_idx);
+
+    Mat alpha64;
+    alpha.convertTo(alpha64, CV_64F);
+    weights.assign(support_vectors.cols, 0);
+    for(int i=0;i<sv_idx.total();i++)
+    {
+        const float *sv = support_vectors.ptr<float>(sv_idx.at<int>(i));
+        double a = alpha64.at<double>(i);
+        for(int j=0;j<support_vectors.cols;j++)
+            weights[j] += a*sv[j];
+    }
+
+    bias = -rho;
+}
+
+LinearCarClassifier::~LinearCarClassifier()
+{
+
+}
+
+Ptr<SVM> LinearCarClassifier::getSVM()
+{
+    return svm;
+}
+
+int LinearCarClassifier::getDescriptorSize()
+{
+    return weights.size();
+}
+
+float LinearCarClassifier::Score(const float *descriptor)
+{
+    float score;
+    Dot4(&weights[0], descriptor, weights.size(), 1, &score);
+
+    return score + bias;
+}
+
+void LinearCarClassifier::Score(const float *descriptors, int count, float *scores)
+{
+    int size = weights.size();
+
+    for(int i=0;i<count;i+=4)
+    {
+        Dot4(&weights[0], descriptors + i*size, size, min(4, count - i), scores + i);
+
+        for(int j=i;j<min(i + 4, count);j++)
+            scores[j] += bias;
+    }
+}
@@ -0,0 +1,48 @@
+/*
+ * Traffic Management UAV.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#ifndef CLASSIFIER_H_
+#define CLASSIFIER_H_
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+/*
+ * Linear SVM collapsed into its primal form.
+ *
+ * The score of a descriptor is w.x + b, the same value returned by
+ * svm->predict(x, result, StatModel::RAW_OUTPUT).
+ */
+class LinearCarClassifier
+{
+    private:
+        cv::Ptr<cv::ml::SVM> svm;
+        std::vector<float> weights;
+        float bias;
+    public:
+        LinearCarClassifier(cv::Ptr<cv::ml::SVM>);
+        ~LinearCarClassifier();
+        cv::Ptr<cv::ml::SVM> getSVM();
+        int getDescriptorSize();
+        float Score(const float*);
+        void Score(const float*, int, float*);
+};
+
+#endif
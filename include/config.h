@@ -41,6 +41,7 @@ struct Config
     // Optical flow
     cv::Size of_subPixWinSize;
     cv::Size of_winSize;
+    int of_max_level;
     cv::TermCriteria of_termcrit;
     // Draw step
     cv::Scalar cars_rect_color;
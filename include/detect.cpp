@@ -19,9 +19,13 @@
  */
 
 #include <cmath>
+#include <memory>
 #include <algorithm>
 
 #include "detect.h"
+#include "hoggrid.h"
+#include "threadpool.h"
+#include "profiler.h"
 #include "aux.h"
 
 using namespace std;
@@ -37,6 +41,21 @@ double CalcVariance(Mat &image)
     return pow(std_dev[0], 2);
 }
 
+double CalcVariance(Mat &sum, Mat &sqsum, Rect rect)
+{
+    int x0 = rect.x;
+    int y0 = rect.y;
+    int x1 = rect.x + rect.width;
+    int y1 = rect.y + rect.height;
+    double n = rect.area();
+    
+    double s = sum.at<int>(y1, x1) - sum.at<int>(y0, x1) - sum.at<int>(y1, x0) + sum.at<int>(y0, x0);
+    double sq = sqsum.at<double>(y1, x1) - sqsum.at<double>(y0, x1) - sqsum.at<double>(y1, x0) + sqsum.at<double>(y0, x0);
+    double mean = s/n;
+    
+    return std::max(sq/n - mean*mean, 0.0);
+}
+
 Mat getHOGDescriptors(Mat image, Config &config, int mode)
 {
 	if (mode == VERTICAL_SEARCH)
@@ -151,9 +170,65 @@ vector<Rect> NonMaximaSupression(vector<Rect> boxes, float overlapThresh)
     return output_boxes;
 }
 
-void DetectCars(Mat &image, Ptr<SVM> svm, Config &config,
-                SensorsData &sensors_data, vector<Car> &cars,
-                vector<Rect> &rois, int mode)
+// Sliding window and grid steps of a search, in cells of the HOG grid
+static void getSearchWindow(Config &config, int mode, int cell_size, int &win_cols, int &win_rows,
+                            int &step_cols, int &step_rows)
+{
+    // The HOG grid is always built in the horizontal orientation (the
+    // vertical search rotates the ROI), and the windows are aligned to its cells
+    win_cols = config.sliding_window_width/cell_size;
+    win_rows = config.sliding_window_height/cell_size;
+    step_cols = max(1, cvRound(float(config.sliding_window_horizontal_step)/cell_size));
+    step_rows = max(1, cvRound(float(config.sliding_window_vertical_step)/cell_size));
+    if (mode == VERTICAL_SEARCH)
+        swap(step_cols, step_rows);
+}
+
+void PrepareSearch(Mat &level_image, SearchRegion &region, int mode)
+{
+    Rect search_rect = region.rect;
+    Mat search_image = level_image(search_rect);
+    
+    // Integral images for the variance filter
+    {
+        PROFILE_SCOPE("detect.variance");
+        integral(search_image, region.sum, region.sqsum);
+    }
+    
+    // Gradients and block histograms of the whole region, shared by all
+    // windows. The rotated region keeps a one pixel margin, so the
+    // gradients on its borders are the same of the not rotated one.
+    {
+        PROFILE_SCOPE("detect.hog");
+        Mat grid_image = search_image;
+        Mat rotated_image;
+        if (mode == VERTICAL_SEARCH)
+        {
+            Rect margin_rect = Rect(search_rect.x - 1, search_rect.y - 1, search_rect.width + 2, search_rect.height + 2) &
+                               Rect(0, 0, level_image.cols, level_image.rows);
+            transpose(level_image(margin_rect), rotated_image);
+            flip(rotated_image, rotated_image, 1);
+            grid_image = rotated_image(Rect(margin_rect.y + margin_rect.height - search_rect.y - search_rect.height,
+                                            search_rect.x - margin_rect.x,
+                                            search_rect.height, search_rect.width));
+        }
+        region.grid.Compute(grid_image);
+    }
+}
+
+int getSearchRows(SearchRegion &region, Config &config, int mode)
+{
+    int win_cols, win_rows, step_cols, step_rows;
+    getSearchWindow(config, mode, region.grid.getCellSize(), win_cols, win_rows, step_cols, step_rows);
+    
+    if (region.grid.getRows() < win_rows)
+        return 0;
+    
+    return (region.grid.getRows() - win_rows)/step_rows + 1;
+}
+
+vector<Rect> SearchCars(SearchRegion &region, int row, LinearCarClassifier &classifier, Config &config,
+                        OccupancyGrid &occupancy, int mode)
 {
     vector<Rect> cars_rect;
 	
@@ -170,91 +245,175 @@ void DetectCars(Mat &image, Ptr<SVM> svm, Config &config,
 		sliding_window_height = config.sliding_window_width;
 	}
 	
-    for(int r=0;r<rois.size();r++)
+    HOGGrid &grid = region.grid;
+    Rect search_rect = region.rect;
+    float s = region.scale;
+    int cell_size = grid.getCellSize();
+    int win_cols, win_rows, step_cols, step_rows;
+    getSearchWindow(config, mode, cell_size, win_cols, win_rows, step_cols, step_rows);
+    int cy = row*step_rows;
+    
+    int descriptor_size = grid.getDescriptorSize(win_cols, win_rows);
+    CV_Assert(descriptor_size == classifier.getDescriptorSize());
+    
+    // Descriptors of the windows of the row, scored in a single batch
+    vector<float> row_descriptors(max(grid.getCols(), 1)*descriptor_size);
+    vector<float> row_scores(max(grid.getCols(), 1));
+    vector<Rect> row_rects;
+    vector<int> row_cols;
+    
     {
-        int min_i = rois[r].y;
-        int max_i = rois[r].y + rois[r].height;
-        int min_j = rois[r].x;
-        int max_j = rois[r].x + rois[r].width;
-        
-        for(float s = config.pyramid_initial_scale;                     // Pyramid search method
-            s <= config.pyramid_final_scale;
-            s += config.pyramid_scale_step)
+        PROFILE_SCOPE("detect.variance");
+        for(int cx = 0;
+            cx <= (grid.getCols() - win_cols);
+            cx += step_cols)
+        {
+            Rect sliding_rect;
+            if (mode == HORIZONTAL_SEARCH)
+                sliding_rect = Rect(search_rect.x + cx*cell_size,
+                                    search_rect.y + cy*cell_size,
+                                    sliding_window_width, sliding_window_height);
+            else
+                sliding_rect = Rect(search_rect.x + cy*cell_size,
+                                    search_rect.y + search_rect.height - cx*cell_size - sliding_window_height,
+                                    sliding_window_width, sliding_window_height);
+            // Variance filter
+            if (CalcVariance(region.sum, region.sqsum, sliding_rect - search_rect.tl()) <= config.variance_threshold)
+                continue;
+            // Skip the windows over already tracked cars
+            if (occupancy.Overlaps(Rect(sliding_rect.x/s, sliding_rect.y/s,
+                                        sliding_rect.width/s, sliding_rect.height/s)))
+                continue;
+            row_rects.push_back(sliding_rect);
+            row_cols.push_back(cx);
+        }
+    }
+    
+    // HOG
+    {
+        PROFILE_SCOPE("detect.hog");
+        for(unsigned int k=0;k<row_cols.size();k++)
+            grid.getDescriptor(row_cols[k], cy, win_cols, win_rows,
+                               &row_descriptors[k*descriptor_size]);
+    }
+    
+    // SVM
+    {
+        PROFILE_SCOPE("detect.svm");
+        classifier.Score(&row_descriptors[0], row_cols.size(), &row_scores[0]);
+    }
+    
+    // Image mirror filter (the mirrored blocks are computed on demand)
+    int candidates = 0;
+    {
+        PROFILE_SCOPE("detect.hog");
+        for(unsigned int k=0;k<row_cols.size();k++)
         {
-            Mat resized_gray_image;
-            resize(image, resized_gray_image, Size(), s, s);
-            for(int i = min_i*s;
-                i < (max_i*s - sliding_window_height);
-                i += config.sliding_window_vertical_step)
+            if (row_scores[k] < config.svm_min_hyperplane_distance)
             {
-                for(int j = min_j*s;
-                    j < (max_j*s - sliding_window_width);
-                    j += config.sliding_window_horizontal_step)
-                {
-                    Rect sliding_rect(j, i, sliding_window_width,
-                                      sliding_window_height);
-                    vector<Point2f> rect_corners;
-                    rect_corners.push_back(Point2f(sliding_rect.x, sliding_rect.y));
-                    rect_corners.push_back(Point2f(sliding_rect.x + sliding_rect.width, sliding_rect.y));
-                    rect_corners.push_back(Point2f(sliding_rect.x + sliding_rect.width, sliding_rect.y + sliding_rect.height));
-                    rect_corners.push_back(Point2f(sliding_rect.x, sliding_rect.y + sliding_rect.height));
-                    bool is_inside = false;
-                    for(int c=0;c<cars.size();c++)
-                    {
-                        if (cars[c].getRect().x == j)
-                            if (cars[c].getRect().y == i)
-                            {
-                                is_inside = true;
-                                break;
-                            }
-                        for(int k=0;k<cars[c].getRectPoints().size();k++)
-                        {
-                            if (pointPolygonTest(rect_corners, cars[c].getRectPoints()[k], false) >= 0)
-                            {
-                                is_inside = true;
-                                break;
-                            }
-                        }
-                    }
-                    if (is_inside)
-                        continue;
-                    Mat sliding_mat = resized_gray_image(sliding_rect).clone();
-                    // Variance filter
-                    if (CalcVariance(sliding_mat) > config.variance_threshold)
-                    {
-                        // HOG
-                        vector<float> hyperplane_distance;
-                        svm->predict(getHOGDescriptors(sliding_mat, config, mode),
-                                     hyperplane_distance, 1);
-                        if (hyperplane_distance[0] < config.svm_min_hyperplane_distance)
-                        {
-                            // Image mirror filter
-                            Mat car_flip;
-                            if (mode == HORIZONTAL_SEARCH)
-                                flip(sliding_mat, car_flip, 0);
-                            else
-                                flip(sliding_mat, car_flip, 1);
-                            vector<float> hdf;
-                            svm->predict(getHOGDescriptors(car_flip, config, mode),
-                                         hdf, 1);
-                            if (hdf[0] < config.svm_min_hyperplane_distance)
-                            {
-                                cars_rect.push_back(Rect(j/s, i/s, sliding_window_width,
-                                                     sliding_window_height));
-                            }
-                        }
-                    }
-                }
+                grid.getDescriptor(row_cols[k], cy, win_cols, win_rows,
+                                   &row_descriptors[candidates*descriptor_size], true);
+                row_rects[candidates] = row_rects[k];
+                candidates++;
             }
         }
     }
+    {
+        PROFILE_SCOPE("detect.svm");
+        classifier.Score(&row_descriptors[0], candidates, &row_scores[0]);
+    }
+    
+    for(int k=0;k<candidates;k++)
+        if (row_scores[k] < config.svm_min_hyperplane_distance)
+            cars_rect.push_back(Rect(row_rects[k].x/s, row_rects[k].y/s, sliding_window_width,
+                                     sliding_window_height));
+    
+    return cars_rect;
+}
+
+vector<Rect> SearchCars(Mat &level_image, Rect search_rect, float s,
+                        LinearCarClassifier &classifier, Config &config,
+                        OccupancyGrid &occupancy, int mode)
+{
+    SearchRegion region;
+    region.rect = search_rect;
+    region.scale = s;
+    PrepareSearch(level_image, region, mode);
+    
+    vector<Rect> cars_rect;
+    for(int row=0;row<getSearchRows(region, config, mode);row++)
+    {
+        vector<Rect> row_cars = SearchCars(region, row, classifier, config, occupancy, mode);
+        cars_rect.insert(cars_rect.end(), row_cars.begin(), row_cars.end());
+    }
+    
+    return cars_rect;
+}
+
+void DetectCars(FramePyramid &pyramid, LinearCarClassifier &classifier, Config &config,
+                TrackTable &cars, OccupancyGrid &occupancy, vector<Rect> &rois, int mode)
+{
+    PROFILE_SCOPE("detect");
+    ThreadPool &pool = ThreadPool::getInstance();
+    
+    // One region for each ROI and pyramid level. Its HOG grid and integral
+    // images are computed once and shared by the searches of all its rows.
+    int window_width = (mode == HORIZONTAL_SEARCH)? config.sliding_window_width:config.sliding_window_height;
+    vector<unique_ptr<SearchRegion> > regions;
+    for(unsigned int r=0;r<rois.size();r++)
+    {
+        // Pyramid search method
+        for(int l=0;l<pyramid.getLevels();l++)
+        {
+            float s = pyramid.getScale(l);
+            Rect search_rect = Rect(rois[r].x*s, rois[r].y*s, rois[r].width*s, rois[r].height*s) &
+                               Rect(0, 0, pyramid.getLevel(l).cols, pyramid.getLevel(l).rows);
+            if (search_rect.width < window_width)
+                continue;
+            
+            regions.push_back(unique_ptr<SearchRegion>(new SearchRegion));
+            regions.back()->level = l;
+            regions.back()->scale = s;
+            regions.back()->rect = search_rect;
+        }
+    }
+    
+    pool.ParallelFor(0, regions.size(), [&](int i)
+    {
+        PrepareSearch(pyramid.getLevel(regions[i]->level), *regions[i], mode);
+    });
+    
+    // Then the window rows of all the regions are searched in parallel
+    vector<int> rows_region;
+    vector<int> rows;
+    for(unsigned int i=0;i<regions.size();i++)
+    {
+        for(int row=0;row<getSearchRows(*regions[i], config, mode);row++)
+        {
+            rows_region.push_back(i);
+            rows.push_back(row);
+        }
+    }
+    
+    vector<vector<Rect> > rows_cars(rows.size());
+    pool.ParallelFor(0, rows.size(), [&](int t)
+    {
+        rows_cars[t] = SearchCars(*regions[rows_region[t]], rows[t], classifier, config, occupancy, mode);
+    });
+    
+    vector<Rect> cars_rect;
+    for(unsigned int t=0;t<rows.size();t++)
+        cars_rect.insert(cars_rect.end(), rows_cars[t].begin(), rows_cars[t].end());
     
     // Non-Maxima Supression filter
-    cars_rect = NonMaximaSupression(cars_rect);
+    {
+        PROFILE_SCOPE("detect.nms");
+        cars_rect = NonMaximaSupression(cars_rect);
+    }
         
     // Add cars
     for(unsigned int i=0;i<cars_rect.size();i++)
-        cars.push_back(Car(cars_rect[i], config, sensors_data, svm));
+        cars.Add(cars_rect[i]);
 }
 
 vector<Point2f> DetectKeyPoints(Mat &image, Config &config)
@@ -265,22 +424,13 @@ vector<Point2f> DetectKeyPoints(Mat &image, Config &config)
     return KeyPoint2Point2f(keypoints);
 }
 
-void ClassifingKeyPoints(vector<Point2f> &kp, vector<Car> &cars)
+void ClassifingKeyPoints(vector<Point2f> &kp, OccupancyGrid &occupancy)
 {
-    for(unsigned int i=0;i<cars.size();i++)
-    {
-        for(unsigned int j=0;j<kp.size();j++)
-        {
-            vector<Point2f> rect_corners;
-            rect_corners.push_back(Point2f(cars[i].getRect().x, cars[i].getRect().y));
-            rect_corners.push_back(Point2f(cars[i].getRect().x+cars[i].getRect().width, cars[i].getRect().y));
-            rect_corners.push_back(Point2f(cars[i].getRect().x+cars[i].getRect().width, cars[i].getRect().y+cars[i].getRect().height));
-            rect_corners.push_back(Point2f(cars[i].getRect().x, cars[i].getRect().y+cars[i].getRect().height));
-            if (pointPolygonTest(rect_corners, kp[j], false) >= 0)
-            {
-                kp.erase(kp.begin()+j);
-                j--;
-            }
-        }
-    }
+    // Keep only the background keypoints
+    unsigned int n = 0;
+    for(unsigned int i=0;i<kp.size();i++)
+        if (!occupancy.Contains(kp[i]))
+            kp[n++] = kp[i];
+    
+    kp.resize(n);
 }
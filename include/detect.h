@@ -26,15 +26,21 @@
 
 #include "config.h"
 #include "sensors_data.h"
-#include "car.h"
+#include "tracks.h"
 #include "bgtracking.h"
+#include "classifier.h"
+#include "occupancy.h"
+#include "pyramid.h"
+#include "hoggrid.h"
 
 #define HORIZONTAL_SEARCH 0
 #define VERTICAL_SEARCH 1
 
 double CalcVariance(cv::Mat&);
 
-cv::Mat getHOGDescriptors(cv::Mat&, Config*);
+double CalcVariance(cv::Mat&, cv::Mat&, cv::Rect);
+
+cv::Mat getHOGDescriptors(cv::Mat, Config&, int mode=HORIZONTAL_SEARCH);
 
 int max(int, int);
 
@@ -52,12 +58,33 @@ std::vector<int> argsort(std::vector<int>);
 std::vector<cv::Rect> NonMaximaSupression(std::vector<cv::Rect>,
 										  float overlapThresh=0.4);
 
-void DetectCars(cv::Mat&, cv::Ptr<cv::ml::SVM>, Config&, SensorsData&,
-                std::vector<Car>&, std::vector<cv::Rect>&,
-                int mode=HORIZONTAL_SEARCH);
+// A ROI at a pyramid level: its integral images and HOG grid are computed
+// once by PrepareSearch() and shared by the searches of its window rows
+struct SearchRegion
+{
+    int level;
+    float scale;
+    cv::Rect rect;                                                      // In the level image
+    cv::Mat sum;
+    cv::Mat sqsum;
+    HOGGrid grid;
+};
+
+void PrepareSearch(cv::Mat&, SearchRegion&, int mode=HORIZONTAL_SEARCH);
+
+int getSearchRows(SearchRegion&, Config&, int mode=HORIZONTAL_SEARCH);
+
+std::vector<cv::Rect> SearchCars(SearchRegion&, int, LinearCarClassifier&, Config&,
+                                 OccupancyGrid&, int mode=HORIZONTAL_SEARCH);
+
+std::vector<cv::Rect> SearchCars(cv::Mat&, cv::Rect, float, LinearCarClassifier&,
+                                 Config&, OccupancyGrid&, int mode=HORIZONTAL_SEARCH);
+
+void DetectCars(FramePyramid&, LinearCarClassifier&, Config&, TrackTable&,
+                OccupancyGrid&, std::vector<cv::Rect>&, int mode=HORIZONTAL_SEARCH);
 
 std::vector<cv::Point2f> DetectKeyPoints(cv::Mat&, Config&);
 
-void ClassifingKeyPoints(std::vector<cv::Point2f>&, std::vector<Car>&);
+void ClassifingKeyPoints(std::vector<cv::Point2f>&, OccupancyGrid&);
 
 #endif
@@ -0,0 +1,252 @@
+/*
+ * Traffic Management UAV.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+#include "hoggrid.h"
+
+using namespace std;
+using namespace cv;
+
+HOGGrid::HOGGrid(int c, int n)
+{
+    cell_size = c;
+    nbins = n;
+    cols = 0;
+    rows = 0;
+
+    // Weights of each pixel of a 2x2 cells block: Gaussian window and
+    // bilinear interpolation between the cells, as cv::HOGDescriptor.
+    // Flipping a block upside down moves the Gaussian center one pixel up.
+    int block_size = 2*cell_size;
+    float sigma = (block_size + block_size)/8.0;
+    float scale = 1.0/(2*sigma*sigma);
+    for(int y=0;y<block_size;y++)
+    {
+        for(int x=0;x<block_size;x++)
+        {
+            float dx = x - block_size*0.5;
+            float dy = y - block_size*0.5;
+            float gaussian = exp(-(dx*dx + dy*dy)*scale);
+            float mirror_gaussian = exp(-(dx*dx + (dy + 1)*(dy + 1))*scale);
+
+            float cell_x = (x + 0.5)/cell_size - 0.5;
+            float cell_y = (y + 0.5)/cell_size - 0.5;
+            int cx0 = floor(cell_x);
+            int cy0 = floor(cell_y);
+            float fx = cell_x - cx0;
+            float fy = cell_y - cy0;
+
+            for(int k=0;k<4;k++)
+            {
+                int cx = cx0 + k/2;
+                int cy = cy0 + k%2;
+                float w = ((k/2)? fx:(1 - fx))*((k%2)? fy:(1 - fy));
+                if ((cx < 0) or (cx > 1) or (cy < 0) or (cy > 1))
+                {
+                    cx = cy = 0;
+                    w = 0;
+                }
+                block_cells.push_back(cx*2 + cy);                       // Cells are stored column by column
+                block_weights.push_back(gaussian*w);
+                mirror_weights.push_back(mirror_gaussian*w);
+            }
+        }
+    }
+}
+
+HOGGrid::~HOGGrid()
+{
+
+}
+
+void HOGGrid::ComputeBlock(int bx, int by, vector<float> &weights, float *hist)
+{
+    int block_size = 2*cell_size;
+    int width = cols*cell_size;
+
+    for(int i=0;i<4*nbins;i++)
+        hist[i] = 0;
+
+    for(int y=0;y<block_size;y++)
+    {
+        int p = 2*((by*cell_size + y)*width + bx*cell_size);
+        const int *cell = &block_cells[4*y*block_size];
+        const float *weight = &weights[4*y*block_size];
+        for(int x=0;x<block_size;x++, p+=2, cell+=4, weight+=4)
+        {
+            for(int k=0;k<4;k++)
+            {
+                float *h = hist + cell[k]*nbins;
+                h[qangle[p]] += weight[k]*grad[p];
+                h[qangle[p+1]] += weight[k]*grad[p+1];
+            }
+        }
+    }
+
+    this->NormalizeBlock(hist);
+}
+
+void HOGGrid::NormalizeBlock(float *hist)
+{
+    int size = 4*nbins;
+
+    // L2-Hys, as cv::HOGDescriptor::normalizeBlockHistogram
+    float sum = 0;
+    for(int i=0;i<size;i++)
+        sum += hist[i]*hist[i];
+
+    float scale = 1.0/(sqrt(sum) + size*0.1);
+    sum = 0;
+    for(int i=0;i<size;i++)
+    {
+        hist[i] = min(hist[i]*scale, 0.2f);
+        sum += hist[i]*hist[i];
+    }
+
+    scale = 1.0/(sqrt(sum) + 1e-3);
+    for(int i=0;i<size;i++)
+        hist[i] *= scale;
+}
+
+void HOGGrid::Compute(Mat &image)
+{
+    cols = image.cols/cell_size;
+    rows = image.rows/cell_size;
+
+    if ((cols < 2) or (rows < 2))
+    {
+        blocks.clear();
+        mirror_blocks.clear();
+        mirror_ready.clear();
+        return;
+    }
+
+    // Centered [-1 0 1] derivatives and unsigned orientations
+    Sobel(image, dx, CV_32F, 1, 0, 1);
+    Sobel(image, dy, CV_32F, 0, 1, 1);
+    cartToPolar(dx, dy, magnitude, angle);
+
+    int width = cols*cell_size;
+    int height = rows*cell_size;
+    float angle_scale = nbins/M_PI;
+
+    // Orientation bins of each pixel, split between the two nearest bins
+    qangle.resize(2*width*height);
+    grad.resize(2*width*height);
+    for(int y=0;y<height;y++)
+    {
+        const float *mag_row = magnitude.ptr<float>(y);
+        const float *ang_row = angle.ptr<float>(y);
+        for(int x=0;x<width;x++)
+        {
+            float a = ang_row[x]*angle_scale - 0.5;                     // Angles in [pi, 2*pi) fold into the same bins
+            int bin = floor(a);
+            a -= bin;
+
+            if (bin < 0)
+                bin += nbins;
+            else if (bin >= nbins)
+                bin -= nbins;
+
+            int p = 2*(y*width + x);
+            qangle[p] = bin;
+            qangle[p+1] = (bin + 1 < nbins)? bin + 1:0;
+            grad[p] = mag_row[x]*(1 - a);
+            grad[p+1] = mag_row[x]*a;
+        }
+    }
+
+    // Block histograms
+    int hist_size = 4*nbins;
+    blocks.resize((cols - 1)*(rows - 1)*hist_size);
+    for(int by=0;by<rows-1;by++)
+        for(int bx=0;bx<cols-1;bx++)
+            this->ComputeBlock(bx, by, block_weights, &blocks[(by*(cols - 1) + bx)*hist_size]);
+
+    // Only a few windows need the mirrored blocks
+    mirror_blocks.resize(blocks.size());
+    mirror_ready.assign((cols - 1)*(rows - 1), false);
+}
+
+int HOGGrid::getCellSize()
+{
+    return cell_size;
+}
+
+int HOGGrid::getCols()
+{
+    return cols;
+}
+
+int HOGGrid::getRows()
+{
+    return rows;
+}
+
+int HOGGrid::getDescriptorSize(int win_cols, int win_rows)
+{
+    return (win_cols - 1)*(win_rows - 1)*4*nbins;
+}
+
+void HOGGrid::getDescriptor(int cx, int cy, int win_cols, int win_rows, float *des, bool mirror)
+{
+    int hist_size = 4*nbins;
+
+    // The mirrored blocks are computed by the first window that needs them
+    unique_lock<mutex> lock(mirror_mt, defer_lock);
+    if (mirror)
+        lock.lock();
+
+    // Blocks are stored column by column, as cv::HOGDescriptor does
+    for(int bx=0;bx<win_cols-1;bx++)
+    {
+        for(int by=0;by<win_rows-1;by++)
+        {
+            if (!mirror)
+            {
+                memcpy(des, &blocks[((cy + by)*(cols - 1) + cx + bx)*hist_size],
+                       hist_size*sizeof(float));
+            }
+            else
+            {
+                // Upside-down window: the block rows, the cells inside each
+                // block and the orientation bins are mirrored
+                int b = (cy + win_rows - 2 - by)*(cols - 1) + cx + bx;
+                if (!mirror_ready[b])
+                {
+                    this->ComputeBlock(cx + bx, cy + win_rows - 2 - by, mirror_weights, &mirror_blocks[b*hist_size]);
+                    mirror_ready[b] = true;
+                }
+
+                const float *src = &mirror_blocks[b*hist_size];
+                for(int c=0;c<4;c++)
+                {
+                    const float *src_cell = src + ((c/2)*2 + 1 - c%2)*nbins;
+                    for(int k=0;k<nbins;k++)
+                        des[c*nbins + k] = src_cell[nbins - 1 - k];
+                }
+            }
+            des += hist_size;
+        }
+    }
+}
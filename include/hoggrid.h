@@ -0,0 +1,76 @@
+/*
+ * Traffic Management UAV.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#ifndef HOG_GRID_H_
+#define HOG_GRID_H_
+
+#include <vector>
+#include <mutex>
+#include <opencv2/opencv.hpp>
+
+// HOG parameters used to train hog-svm-cars.xml (see hog-svm_trainer)
+#define HOG_CELL_SIZE 5
+#define HOG_BINS 18
+
+/*
+ * Dense HOG grid of an image.
+ * 
+ * The gradients and the block histograms (2x2 cells, one cell stride,
+ * L2-Hys normalized) are computed once for the whole image. The
+ * descriptor of any window aligned to the cell grid is then just a
+ * copy of its blocks. It matches the cv::HOGDescriptor one except for the
+ * gradients at the window border: cv::HOGDescriptor reflects the window
+ * (BORDER_REFLECT_101), the grid uses the real neighbouring pixels.
+ * After Compute(), several threads can get descriptors of the same grid.
+ */
+class HOGGrid
+{
+    private:
+        int cell_size;
+        int nbins;
+        int cols;                                                       // Number of cells
+        int rows;
+        std::vector<int> block_cells;
+        std::vector<float> block_weights;                               // Gaussian and spatial weights of each block pixel
+        std::vector<float> mirror_weights;                              // The same, for the upside-down block
+        std::vector<float> blocks;                                      // Normalized block histograms
+        std::vector<float> mirror_blocks;                               // Computed on demand
+        std::vector<bool> mirror_ready;
+        std::mutex mirror_mt;                                           // The windows of a grid are searched in parallel
+        std::vector<int> qangle;                                        // Two orientation bins per pixel
+        std::vector<float> grad;                                        // and their magnitudes
+        cv::Mat dx;
+        cv::Mat dy;
+        cv::Mat magnitude;
+        cv::Mat angle;
+        void ComputeBlock(int, int, std::vector<float>&, float*);
+        void NormalizeBlock(float*);
+    public:
+        HOGGrid(int c=HOG_CELL_SIZE, int n=HOG_BINS);
+        ~HOGGrid();
+        void Compute(cv::Mat&);
+        int getCellSize();
+        int getCols();
+        int getRows();
+        int getDescriptorSize(int, int);
+        void getDescriptor(int, int, int, int, float*, bool mirror=false);
+};
+
+#endif
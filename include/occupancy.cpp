@@ -0,0 +1,118 @@
+/*
+ * Traffic Management UAV.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#include <cmath>
+
+#include "occupancy.h"
+
+using namespace std;
+using namespace cv;
+
+OccupancyGrid::OccupancyGrid(Size frame_size, int b)
+{
+    bucket_size = b;
+    cols = (frame_size.width + bucket_size - 1)/bucket_size;
+    rows = (frame_size.height + bucket_size - 1)/bucket_size;
+    bucket_start.assign(cols*rows + 1, 0);
+}
+
+OccupancyGrid::~OccupancyGrid()
+{
+
+}
+
+// Positions out of the frame are clamped to the border buckets
+int OccupancyGrid::getCol(float x)
+{
+    int c = floor(x/bucket_size);
+    return (c < 0)? 0:((c >= cols)? cols - 1:c);
+}
+
+int OccupancyGrid::getRow(float y)
+{
+    int r = floor(y/bucket_size);
+    return (r < 0)? 0:((r >= rows)? rows - 1:r);
+}
+
+void OccupancyGrid::Build(TrackTable &cars)
+{
+    rects.resize(cars.getSize());
+    points.resize(cars.getSize()*RECT_POINTS);
+    for(int i=0;i<cars.getSize();i++)
+    {
+        rects[i] = cars.getRect(i);
+        const Point2f *p = cars.getRectPoints(i);
+        for(int k=0;k<RECT_POINTS;k++)
+            points[i*RECT_POINTS + k] = p[k];
+    }
+
+    // Count the cars of each bucket, then fill them (counting sort)
+    bucket_start.assign(cols*rows + 1, 0);
+    for(unsigned int i=0;i<rects.size();i++)
+        for(int r=getRow(rects[i].y);r<=getRow(rects[i].y + rects[i].height);r++)
+            for(int c=getCol(rects[i].x);c<=getCol(rects[i].x + rects[i].width);c++)
+                bucket_start[r*cols + c + 1]++;
+
+    for(int b=0;b<cols*rows;b++)
+        bucket_start[b+1] += bucket_start[b];
+
+    entries.resize(bucket_start[cols*rows]);
+    vector<int> fill(bucket_start.begin(), bucket_start.end() - 1);
+    for(unsigned int i=0;i<rects.size();i++)
+        for(int r=getRow(rects[i].y);r<=getRow(rects[i].y + rects[i].height);r++)
+            for(int c=getCol(rects[i].x);c<=getCol(rects[i].x + rects[i].width);c++)
+                entries[fill[r*cols + c]++] = i;
+}
+
+// Is the point inside (or on the border of) a car bounding box?
+bool OccupancyGrid::Contains(Point2f p)
+{
+    int b = getRow(p.y)*cols + getCol(p.x);
+    for(int e=bucket_start[b];e<bucket_start[b+1];e++)
+    {
+        Rect &r = rects[entries[e]];
+        if ((p.x >= r.x) and (p.x <= r.x + r.width) and (p.y >= r.y) and (p.y <= r.y + r.height))
+            return true;
+    }
+
+    return false;
+}
+
+// Does the window cover a point of an already tracked car?
+bool OccupancyGrid::Overlaps(Rect window)
+{
+    for(int r=getRow(window.y);r<=getRow(window.y + window.height);r++)
+    {
+        for(int c=getCol(window.x);c<=getCol(window.x + window.width);c++)
+        {
+            int b = r*cols + c;
+            for(int e=bucket_start[b];e<bucket_start[b+1];e++)
+            {
+                const Point2f *p = &points[entries[e]*RECT_POINTS];
+                for(int k=0;k<RECT_POINTS;k++)
+                    if ((p[k].x >= window.x) and (p[k].x <= window.x + window.width) and
+                        (p[k].y >= window.y) and (p[k].y <= window.y + window.height))
+                        return true;
+            }
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,55 @@
+/*
+ * Traffic Management UAV.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#ifndef OCCUPANCY_H_
+#define OCCUPANCY_H_
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include "tracks.h"
+
+/*
+ * Uniform grid index of the tracked cars footprints.
+ * 
+ * Each bucket lists the cars whose bounding box touches it, so a query
+ * only tests the few cars around a window or a point.
+ */
+class OccupancyGrid
+{
+    private:
+        int bucket_size;
+        int cols;                                                       // Number of buckets
+        int rows;
+        std::vector<int> bucket_start;                                  // Cars of bucket b: entries[bucket_start[b]..bucket_start[b+1]-1]
+        std::vector<int> entries;
+        std::vector<cv::Rect> rects;
+        std::vector<cv::Point2f> points;                                // Rect points of each car (RECT_POINTS per car)
+        int getCol(float);
+        int getRow(float);
+    public:
+        OccupancyGrid(cv::Size, int b=32);
+        ~OccupancyGrid();
+        void Build(TrackTable&);
+        bool Contains(cv::Point2f);
+        bool Overlaps(cv::Rect);
+};
+
+#endif
@@ -0,0 +1,99 @@
+/*
+ * Traffic Management UAV.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#include <cmath>
+
+#include "output.h"
+
+using namespace std;
+using namespace cv;
+
+TrackWriter::TrackWriter(string path, int f)
+{
+    format = f;
+    if (path.empty())
+        out = &cout;
+    else
+    {
+        file.open(path.c_str());
+        out = &file;
+    }
+    out->precision(10);
+    
+    if (isOpened() and (format == OUTPUT_CSV))
+        *out << "frame,id,x,y,width,height,speed,latitude,longitude" << endl;
+}
+
+TrackWriter::~TrackWriter()
+{
+    out->flush();
+}
+
+bool TrackWriter::isOpened()
+{
+    return (out == &cout) or file.is_open();
+}
+
+// The speed of a car is undefined while the background is still
+void TrackWriter::WriteNumber(double value)
+{
+    if (isfinite(value))
+        *out << value;
+    else if (format == OUTPUT_JSONL)
+        *out << "null";
+}
+
+void TrackWriter::Write(unsigned int frame_number, TrackTable &cars)
+{
+    if (format == OUTPUT_JSONL)
+    {
+        *out << "{\"frame\":" << frame_number << ",\"tracks\":[";
+        for(int i=0;i<cars.getSize();i++)
+        {
+            Rect r = cars.getRect(i);
+            *out << ((i == 0)? "":",") << "{\"id\":" << cars.getId(i)
+                 << ",\"x\":" << r.x << ",\"y\":" << r.y
+                 << ",\"width\":" << r.width << ",\"height\":" << r.height
+                 << ",\"speed\":";
+            this->WriteNumber(cars.getSpeed(i));
+            *out << ",\"latitude\":";
+            this->WriteNumber(cars.getLatitude(i));
+            *out << ",\"longitude\":";
+            this->WriteNumber(cars.getLongitude(i));
+            *out << "}";
+        }
+        *out << "]}\n";
+    }
+    else
+    {
+        for(int i=0;i<cars.getSize();i++)
+        {
+            Rect r = cars.getRect(i);
+            *out << frame_number << "," << cars.getId(i) << ","
+                 << r.x << "," << r.y << "," << r.width << "," << r.height << ",";
+            this->WriteNumber(cars.getSpeed(i));
+            *out << ",";
+            this->WriteNumber(cars.getLatitude(i));
+            *out << ",";
+            this->WriteNumber(cars.getLongitude(i));
+            *out << "\n";
+        }
+    }
+}
@@ -0,0 +1,51 @@
+/*
+ * Traffic Management UAV.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#ifndef OUTPUT_H_
+#define OUTPUT_H_
+
+#include <string>
+#include <fstream>
+#include <iostream>
+
+#include "tracks.h"
+
+#define OUTPUT_JSONL 0
+#define OUTPUT_CSV 1
+
+/*
+ * Per frame tracks record, as JSON lines (one object per frame) or CSV
+ * (one row per track). An empty path writes to the standard output.
+ */
+class TrackWriter
+{
+    private:
+        std::ofstream file;
+        std::ostream *out;
+        int format;
+        void WriteNumber(double);
+    public:
+        TrackWriter(std::string path="", int f=OUTPUT_JSONL);
+        ~TrackWriter();
+        bool isOpened();
+        void Write(unsigned int, TrackTable&);
+};
+
+#endif
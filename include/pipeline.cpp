@@ -0,0 +1,215 @@
+/*
+ * Traffic Management UAV.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#include <thread>
+#include <memory>
+
+#include "pipeline.h"
+#include "detect.h"
+#include "profiler.h"
+
+using namespace std;
+using namespace cv;
+
+FramePacket::FramePacket(Config &config, SensorsData &sensors_data)
+    : pyramid(config), cars(config, sensors_data), bg_tracking(vector<Point2f>(), config)
+{
+    number = 0;
+    last = false;
+}
+
+FramePipeline::FramePipeline(Mat &first_frame, LinearCarClassifier &c, Config &p,
+                             SensorsData &sd, vector<Rect> &r)
+    : prev_pyramid(p), cars(p, sd), occupancy(first_frame.size()),
+      bg_tracking(vector<Point2f>(), p), tracker(p)
+{
+    config = &p;
+    sensors_data = &sd;
+    classifier = &c;
+    rois = r;
+    frame_counter = 0;
+    frame_number = 1;                                                   // Frame 0 is the first_frame given here
+    stop = false;
+    
+    cvtColor(first_frame, prev_gray, CV_BGR2GRAY);
+    prev_pyramid.Build(prev_gray);
+    
+    // Detect the cars in first frame
+    vector<Rect> initial_roi;
+    initial_roi.push_back(Rect(0, 0, first_frame.cols, first_frame.rows));
+    occupancy.Build(cars);
+    DetectCars(prev_pyramid, *classifier, *config, cars, occupancy,
+               initial_roi, VERTICAL_SEARCH);
+    
+    // Finding keypoints in first frame
+    vector<Point2f> keypoints = DetectKeyPoints(prev_gray, *config);
+    
+    // Classify keypoints
+    occupancy.Build(cars);
+    ClassifingKeyPoints(keypoints, occupancy);
+    bg_tracking.setKeyPoints(keypoints);
+}
+
+FramePipeline::~FramePipeline()
+{
+    
+}
+
+bool FramePipeline::Decode(VideoCapture &cap, FramePacket &packet)
+{
+    PROFILE_SCOPE("decode");
+    cap >> packet.frame;
+    packet.number = frame_number++;
+    packet.last = packet.frame.empty();
+    
+    return !packet.last;
+}
+
+void FramePipeline::Prepare(FramePacket &packet)
+{
+    if (packet.last)
+        return;
+    
+    {
+        PROFILE_SCOPE("gray");
+        cvtColor(packet.frame, packet.gray, CV_BGR2GRAY);
+    }
+    PROFILE_SCOPE("pyramid");
+    packet.pyramid.Build(packet.gray);
+}
+
+void FramePipeline::Analyse(FramePacket &packet)
+{
+    if (packet.last)
+        return;
+    
+    PROFILE_SCOPE("analyse");
+    
+    // Tracked cars footprints, shared by the keypoints classification and the detection
+    occupancy.Build(cars);
+    
+    // Search for new cars (the ROIs are split among the thread pool)
+    DetectCars(packet.pyramid, *classifier, *config, cars, occupancy,
+               rois, VERTICAL_SEARCH);
+    
+    // Update background and cars tracking
+    bool bg_tracked;
+    {
+        PROFILE_SCOPE("track");
+        bg_tracked = tracker.Update(prev_pyramid, packet.pyramid, bg_tracking, cars, packet.frame, false);
+    }
+    if (!bg_tracked or (frame_counter == config->frames_to_update))
+    {
+        PROFILE_SCOPE("keypoints");
+        vector<Point2f> keypoints = DetectKeyPoints(packet.gray, *config);
+        ClassifingKeyPoints(keypoints, occupancy);
+        bg_tracking.setKeyPoints(keypoints);
+        frame_counter = 0;
+    }
+    frame_counter++;
+    
+    // Results of this frame, for the rendering
+    packet.cars = cars;
+    packet.bg_tracking = bg_tracking;
+    
+    // This frame is the previous one of the next frame. The packet takes
+    // the old buffers, which are no longer needed.
+    swap(prev_gray, packet.gray);
+    swap(prev_pyramid, packet.pyramid);
+}
+
+void FramePipeline::Run(VideoCapture &cap, function<bool(FramePacket&)> render)
+{
+    FramePacket packet(*config, *sensors_data);
+    while(this->Decode(cap, packet))
+    {
+        this->Prepare(packet);
+        this->Analyse(packet);
+        if (!render(packet))
+            break;
+    }
+}
+
+void FramePipeline::RunPipelined(VideoCapture &cap, function<bool(FramePacket&)> render, int n)
+{
+    // Every packet fits in any queue, so a push never waits for long
+    vector<unique_ptr<FramePacket> > packets;
+    SPSCQueue<FramePacket*> free_packets(n);
+    SPSCQueue<FramePacket*> decoded(n);
+    SPSCQueue<FramePacket*> prepared(n);
+    SPSCQueue<FramePacket*> analysed(n);
+    for(int i=0;i<n;i++)
+    {
+        packets.push_back(unique_ptr<FramePacket>(new FramePacket(*config, *sensors_data)));
+        free_packets.Push(packets.back().get());
+    }
+    
+    // The last packet goes down the whole pipeline, and each stage ends after it
+    stop = false;
+    thread decode_thread([&]()
+    {
+        FramePacket *packet;
+        do
+        {
+            packet = free_packets.Pop();
+            if (stop)
+                packet->last = true;
+            else
+                this->Decode(cap, *packet);
+            decoded.Push(packet);
+        } while(!packet->last);
+    });
+    thread prepare_thread([&]()
+    {
+        FramePacket *packet;
+        do
+        {
+            packet = decoded.Pop();
+            this->Prepare(*packet);
+            prepared.Push(packet);
+        } while(!packet->last);
+    });
+    thread analyse_thread([&]()
+    {
+        FramePacket *packet;
+        do
+        {
+            packet = prepared.Pop();
+            this->Analyse(*packet);
+            analysed.Push(packet);
+        } while(!packet->last);
+    });
+    
+    // Rendering in the calling thread (the HighGUI windows belong to it).
+    // After a stop the frames in flight are only drained.
+    while(true)
+    {
+        FramePacket *packet = analysed.Pop();
+        if (packet->last)
+            break;
+        if (!stop and !render(*packet))
+            stop = true;
+        free_packets.Push(packet);
+    }
+    
+    decode_thread.join();
+    prepare_thread.join();
+    analyse_thread.join();
+}
@@ -0,0 +1,95 @@
+/*
+ * Traffic Management UAV.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#ifndef PIPELINE_H_
+#define PIPELINE_H_
+
+#include <vector>
+#include <atomic>
+#include <functional>
+#include <opencv2/opencv.hpp>
+
+#include "config.h"
+#include "sensors_data.h"
+#include "classifier.h"
+#include "pyramid.h"
+#include "tracks.h"
+#include "occupancy.h"
+#include "bgtracking.h"
+#include "tracker.h"
+#include "queue.h"
+
+// Frames in flight of the pipelined mode
+#define PIPELINE_FRAMES 4
+
+/*
+ * A frame and its results. The packets are recycled, so their buffers
+ * are allocated only for the first frames.
+ */
+struct FramePacket
+{
+    cv::Mat frame;
+    cv::Mat gray;
+    FramePyramid pyramid;
+    TrackTable cars;                                                    // Tracks snapshot, for the rendering
+    BGTracking bg_tracking;
+    unsigned int number;                                                // Index in the video
+    bool last;                                                          // End of the capture
+    FramePacket(Config&, SensorsData&);
+};
+
+/*
+ * Frame processing: decode -> gray and pyramids -> tracking and detection
+ * -> render. The render callback runs in the calling thread and returns
+ * false to stop.
+ * 
+ * In the pipelined mode each stage has its own thread, connected to the
+ * next one by a bounded SPSC queue, so the decoding and the rendering of
+ * a frame overlap the tracking of the other ones. The tracking and the
+ * detection stay in one stage: each one needs the result of the other
+ * for the previous frame.
+ */
+class FramePipeline
+{
+    private:
+        Config *config;
+        SensorsData *sensors_data;
+        LinearCarClassifier *classifier;
+        std::vector<cv::Rect> rois;
+        cv::Mat prev_gray;
+        FramePyramid prev_pyramid;
+        TrackTable cars;
+        OccupancyGrid occupancy;
+        BGTracking bg_tracking;
+        TrackerBatch tracker;
+        unsigned int frame_counter;
+        unsigned int frame_number;                                      // Index in the video of the next frame to decode
+        std::atomic<bool> stop;
+        bool Decode(cv::VideoCapture&, FramePacket&);
+        void Prepare(FramePacket&);
+        void Analyse(FramePacket&);
+    public:
+        FramePipeline(cv::Mat&, LinearCarClassifier&, Config&, SensorsData&, std::vector<cv::Rect>&);
+        ~FramePipeline();
+        void Run(cv::VideoCapture&, std::function<bool(FramePacket&)>);
+        void RunPipelined(cv::VideoCapture&, std::function<bool(FramePacket&)>, int n=PIPELINE_FRAMES);
+};
+
+#endif
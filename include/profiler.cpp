@@ -0,0 +1,214 @@
+/*
+ * Traffic Management UAV.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+
+#include "profiler.h"
+
+using namespace std;
+using namespace std::chrono;
+
+static thread_local void *thread_profile = 0;
+
+Profiler::Profiler()
+{
+    enabled = false;
+    tracing = false;
+    origin = steady_clock::now();
+}
+
+Profiler::~Profiler()
+{
+    
+}
+
+Profiler& Profiler::getInstance()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+void Profiler::Enable(bool trace)
+{
+    origin = steady_clock::now();
+    tracing = trace;
+    enabled = true;
+}
+
+bool Profiler::isEnabled()
+{
+    return enabled.load(memory_order_relaxed);
+}
+
+int Profiler::Register(const char *name)
+{
+    lock_guard<mutex> lock(mt);
+    for(unsigned int i=0;i<stages.size();i++)
+        if (stages[i] == name)
+            return i;
+    
+    if (stages.size() == PROFILER_MAX_STAGES)
+        return PROFILER_MAX_STAGES - 1;                                 // Overflow stages share the last one
+    
+    stages.push_back(name);
+    return stages.size() - 1;
+}
+
+Profiler::ThreadProfile* Profiler::getThreadProfile()
+{
+    if (!thread_profile)
+    {
+        ThreadProfile *profile = new ThreadProfile;
+        for(int s=0;s<PROFILER_MAX_STAGES;s++)
+        {
+            profile->total[s] = 0;
+            for(int b=0;b<PROFILER_BUCKETS;b++)
+                profile->counts[s][b] = 0;
+        }
+        
+        lock_guard<mutex> lock(mt);
+        profile->tid = threads.size() + 1;
+        threads.push_back(unique_ptr<ThreadProfile>(profile));
+        thread_profile = profile;
+    }
+    
+    return static_cast<ThreadProfile*>(thread_profile);
+}
+
+// Values up to 15 ns have their own bucket, then 8 buckets per power of two
+int Profiler::getBucket(int64_t ns)
+{
+    if (ns < 16)
+        return max(ns, int64_t(0));
+    
+    int e = 63 - __builtin_clzll(ns);
+    int b = 16 + (e - 4)*8 + ((ns >> (e - 3)) & 7);
+    
+    return min(b, PROFILER_BUCKETS - 1);
+}
+
+// Middle of the bucket range
+double Profiler::getBucketValue(int b)
+{
+    if (b < 16)
+        return b;
+    
+    int e = (b - 16)/8 + 4;
+    int sub = (b - 16)%8;
+    
+    return ldexp(8 + sub + 0.5, e - 3);
+}
+
+void Profiler::Record(int stage, steady_clock::time_point start, steady_clock::time_point end)
+{
+    ThreadProfile *profile = this->getThreadProfile();
+    int64_t ns = duration_cast<nanoseconds>(end - start).count();
+    
+    profile->counts[stage][getBucket(ns)].fetch_add(1, memory_order_relaxed);
+    profile->total[stage].fetch_add(ns, memory_order_relaxed);
+    
+    if (tracing.load(memory_order_relaxed) and (profile->events.size() < 3*PROFILER_MAX_EVENTS))
+    {
+        profile->events.push_back(stage);
+        profile->events.push_back(duration_cast<nanoseconds>(start - origin).count());
+        profile->events.push_back(ns);
+    }
+}
+
+void Profiler::PrintSummary(ostream &out)
+{
+    lock_guard<mutex> lock(mt);
+    
+    out << left << setw(20) << "stage" << right << setw(10) << "count"
+        << setw(12) << "mean (ms)" << setw(12) << "p50 (ms)"
+        << setw(12) << "p95 (ms)" << setw(12) << "p99 (ms)" << endl;
+    
+    for(unsigned int s=0;s<stages.size();s++)
+    {
+        // Merge the threads histograms
+        vector<uint64_t> counts(PROFILER_BUCKETS, 0);
+        uint64_t n = 0;
+        uint64_t total = 0;
+        for(unsigned int t=0;t<threads.size();t++)
+        {
+            for(int b=0;b<PROFILER_BUCKETS;b++)
+            {
+                uint32_t c = threads[t]->counts[s][b].load(memory_order_relaxed);
+                counts[b] += c;
+                n += c;
+            }
+            total += threads[t]->total[s].load(memory_order_relaxed);
+        }
+        if (n == 0)
+            continue;
+        
+        const double percentiles[3] = {0.5, 0.95, 0.99};
+        double values[3];
+        for(int p=0;p<3;p++)
+        {
+            uint64_t rank = ceil(percentiles[p]*n);
+            uint64_t acc = 0;
+            int b = 0;
+            for(;b<PROFILER_BUCKETS-1;b++)
+            {
+                acc += counts[b];
+                if (acc >= rank)
+                    break;
+            }
+            values[p] = getBucketValue(b)/1e6;
+        }
+        
+        out << left << setw(20) << stages[s] << right << setw(10) << n << fixed << setprecision(3)
+            << setw(12) << total/1e6/n << setw(12) << values[0]
+            << setw(12) << values[1] << setw(12) << values[2] << endl;
+        out.unsetf(ios::fixed);
+    }
+}
+
+bool Profiler::WriteTrace(string path)
+{
+    ofstream file(path.c_str());
+    if (!file.is_open())
+        return false;
+    
+    lock_guard<mutex> lock(mt);
+    
+    // Chrome trace event format, complete events ("X") in microseconds
+    file << "{\"traceEvents\":[";
+    bool first = true;
+    file << fixed << setprecision(3);
+    for(unsigned int t=0;t<threads.size();t++)
+    {
+        const vector<int64_t> &events = threads[t]->events;
+        for(unsigned int e=0;e+2<events.size();e+=3)
+        {
+            file << (first? "\n":",\n") << "{\"name\":\"" << stages[events[e]]
+                 << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << threads[t]->tid
+                 << ",\"ts\":" << events[e+1]/1e3 << ",\"dur\":" << events[e+2]/1e3 << "}";
+            first = false;
+        }
+    }
+    file << "\n]}\n";
+    
+    return true;
+}
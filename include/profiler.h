@@ -0,0 +1,105 @@
+/*
+ * Traffic Management UAV.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <vector>
+#include <string>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <memory>
+#include <cstdint>
+#include <iostream>
+
+#define PROFILER_MAX_STAGES 64
+#define PROFILER_BUCKETS 320                                            // Log-linear: 8 buckets per power of two
+#define PROFILER_MAX_EVENTS 1000000                                     // Trace events kept per thread
+
+/*
+ * Stage latency profiler.
+ * 
+ * Each thread records in its own histograms (relaxed atomics, no locks)
+ * and, when tracing, in its own event list. The percentiles and the
+ * Chrome trace (chrome://tracing, Perfetto) are written at the end.
+ * While disabled, a timer costs one flag check.
+ */
+class Profiler
+{
+    private:
+        struct ThreadProfile
+        {
+            int tid;
+            std::atomic<uint32_t> counts[PROFILER_MAX_STAGES][PROFILER_BUCKETS];
+            std::atomic<uint64_t> total[PROFILER_MAX_STAGES];
+            std::vector<int64_t> events;                                // Stage, start and duration (ns)
+        };
+        std::atomic<bool> enabled;
+        std::atomic<bool> tracing;
+        std::chrono::steady_clock::time_point origin;
+        std::mutex mt;                                                  // Registration only
+        std::vector<std::string> stages;
+        std::vector<std::unique_ptr<ThreadProfile> > threads;
+        ThreadProfile* getThreadProfile();
+        static int getBucket(int64_t);
+        static double getBucketValue(int);
+    public:
+        Profiler();
+        ~Profiler();
+        static Profiler& getInstance();
+        void Enable(bool trace=false);
+        bool isEnabled();
+        int Register(const char*);
+        void Record(int, std::chrono::steady_clock::time_point, std::chrono::steady_clock::time_point);
+        void PrintSummary(std::ostream&);
+        bool WriteTrace(std::string);
+};
+
+class ScopedTimer
+{
+    private:
+        int stage;
+        bool active;
+        std::chrono::steady_clock::time_point start;
+    public:
+        ScopedTimer(int s)
+        {
+            stage = s;
+            active = Profiler::getInstance().isEnabled();
+            if (active)
+                start = std::chrono::steady_clock::now();
+        }
+        ~ScopedTimer()
+        {
+            if (active)
+                Profiler::getInstance().Record(stage, start, std::chrono::steady_clock::now());
+        }
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+// Times the rest of the enclosing scope as the stage "name"
+#define PROFILE_SCOPE(name) \
+    static const int PROFILE_CONCAT(profile_stage_, __LINE__) = Profiler::getInstance().Register(name); \
+    ScopedTimer PROFILE_CONCAT(profile_timer_, __LINE__)(PROFILE_CONCAT(profile_stage_, __LINE__))
+
+#endif
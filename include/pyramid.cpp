@@ -0,0 +1,94 @@
+/*
+ * Traffic Management UAV.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#include "pyramid.h"
+
+using namespace std;
+using namespace cv;
+
+FramePyramid::FramePyramid(Config &p)
+{
+    config = &p;
+    of_levels = 0;
+}
+
+FramePyramid::~FramePyramid()
+{
+    
+}
+
+void FramePyramid::Build(Mat &gray_image)
+{
+    image = gray_image;
+    
+    // Detection scales. The buffers of the previous frames are reused.
+    int n = 0;
+    for(float s = config->pyramid_initial_scale;
+        s <= config->pyramid_final_scale;
+        s += config->pyramid_scale_step, n++)
+    {
+        if (n == int(levels.size()))
+        {
+            scales.push_back(s);
+            levels.push_back(Mat());
+        }
+        scales[n] = s;
+        if (s == 1)
+            levels[n] = image;
+        else
+            resize(image, levels[n], Size(), s, s);
+    }
+    scales.resize(n);
+    levels.resize(n);
+    
+    // Optical flow pyramid
+    of_levels = buildOpticalFlowPyramid(image, of_pyramid, config->of_winSize,
+                                        config->of_max_level, true);
+}
+
+Mat& FramePyramid::getImage()
+{
+    return image;
+}
+
+int FramePyramid::getLevels()
+{
+    return levels.size();
+}
+
+float FramePyramid::getScale(int l)
+{
+    return scales[l];
+}
+
+Mat& FramePyramid::getLevel(int l)
+{
+    return levels[l];
+}
+
+vector<Mat>& FramePyramid::getOFPyramid()
+{
+    return of_pyramid;
+}
+
+int FramePyramid::getOFLevels()
+{
+    return of_levels;
+}
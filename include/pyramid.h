@@ -0,0 +1,55 @@
+/*
+ * Traffic Management UAV.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#ifndef PYRAMID_H_
+#define PYRAMID_H_
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include "config.h"
+
+/*
+ * Image pyramids of a gray frame, built once per frame and shared by
+ * the detection (pyramid search scales) and the optical flow trackers
+ * (Lucas-Kanade pyramid, with the Scharr derivatives).
+ */
+class FramePyramid
+{
+    private:
+        Config *config;
+        cv::Mat image;
+        std::vector<float> scales;
+        std::vector<cv::Mat> levels;                                    // Resized frames of the detection
+        std::vector<cv::Mat> of_pyramid;
+        int of_levels;
+    public:
+        FramePyramid(Config&);
+        ~FramePyramid();
+        void Build(cv::Mat&);
+        cv::Mat& getImage();
+        int getLevels();
+        float getScale(int);
+        cv::Mat& getLevel(int);
+        std::vector<cv::Mat>& getOFPyramid();
+        int getOFLevels();
+};
+
+#endif
@@ -0,0 +1,85 @@
+/*
+ * Traffic Management UAV.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#ifndef QUEUE_H_
+#define QUEUE_H_
+
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+/*
+ * Bounded lock-free queue with a single producer and a single consumer.
+ * 
+ * The ring has one free slot to tell full from empty. Push() and Pop()
+ * wait for room or data, first yielding and then sleeping, so a stalled
+ * stage does not burn a core.
+ */
+template<typename T>
+class SPSCQueue
+{
+    private:
+        std::vector<T> ring;
+        std::atomic<size_t> head;                                       // Next slot to pop
+        std::atomic<size_t> tail;                                       // Next slot to push
+        static void Wait(unsigned int tries)
+        {
+            if (tries < 64)
+                std::this_thread::yield();
+            else
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    public:
+        SPSCQueue(size_t n) : ring(n + 1), head(0), tail(0) {}
+        bool TryPush(const T &item)
+        {
+            size_t t = tail.load(std::memory_order_relaxed);
+            size_t next = (t + 1 == ring.size())? 0:t + 1;
+            if (next == head.load(std::memory_order_acquire))
+                return false;
+            ring[t] = item;
+            tail.store(next, std::memory_order_release);
+            return true;
+        }
+        bool TryPop(T &item)
+        {
+            size_t h = head.load(std::memory_order_relaxed);
+            if (h == tail.load(std::memory_order_acquire))
+                return false;
+            item = ring[h];
+            head.store((h + 1 == ring.size())? 0:h + 1, std::memory_order_release);
+            return true;
+        }
+        void Push(const T &item)
+        {
+            for(unsigned int tries=0;!this->TryPush(item);tries++)
+                Wait(tries);
+        }
+        T Pop()
+        {
+            T item;
+            for(unsigned int tries=0;!this->TryPop(item);tries++)
+                Wait(tries);
+            return item;
+        }
+};
+
+#endif
@@ -0,0 +1,197 @@
+/*
+ * Traffic Management UAV.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#include <exception>
+
+#include "threadpool.h"
+
+using namespace std;
+
+static thread_local int worker_index = -1;                              // Index of the worker running this thread (-1 = not a worker)
+
+ThreadPool::ThreadPool(unsigned int n)
+{
+    if (n == 0)
+        n = max(thread::hardware_concurrency(), 1u);
+
+    stop = false;
+    queued = 0;
+    next_worker = 0;
+
+    for(unsigned int i=0;i<n;i++)
+        workers.push_back(unique_ptr<Worker>(new Worker));
+
+    for(unsigned int i=0;i<n;i++)
+        threads.push_back(thread(&ThreadPool::WorkerLoop, this, i));
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        lock_guard<mutex> lock(wake_mt);
+        stop = true;
+    }
+    wake.notify_all();
+
+    for(unsigned int i=0;i<threads.size();i++)
+        threads[i].join();
+}
+
+ThreadPool& ThreadPool::getInstance()
+{
+    static ThreadPool pool;
+    return pool;
+}
+
+unsigned int ThreadPool::getSize()
+{
+    return workers.size();
+}
+
+void ThreadPool::Push(function<void()> task)
+{
+    // Tasks created by a worker stay in its own queue
+    int w = worker_index;
+    if (w < 0)
+        w = next_worker++ % workers.size();
+
+    {
+        lock_guard<mutex> lock(workers[w]->mt);
+        workers[w]->tasks.push_back(move(task));
+    }
+
+    {
+        lock_guard<mutex> lock(wake_mt);
+        queued++;
+    }
+    wake.notify_one();
+}
+
+bool ThreadPool::RunTask(int self)
+{
+    function<void()> task;
+    int n = workers.size();
+
+    // Own queue first (newest task), then steal the oldest task of the others
+    if (self >= 0)
+    {
+        lock_guard<mutex> lock(workers[self]->mt);
+        if (!workers[self]->tasks.empty())
+        {
+            task = move(workers[self]->tasks.back());
+            workers[self]->tasks.pop_back();
+        }
+    }
+
+    for(int i=1;(i<=n) and !task;i++)
+    {
+        Worker *victim = workers[(max(self, 0) + i) % n].get();
+        lock_guard<mutex> lock(victim->mt);
+        if (!victim->tasks.empty())
+        {
+            task = move(victim->tasks.front());
+            victim->tasks.pop_front();
+        }
+    }
+
+    if (!task)
+        return false;
+
+    queued--;
+    task();
+
+    return true;
+}
+
+void ThreadPool::WorkerLoop(int index)
+{
+    worker_index = index;
+
+    while(true)
+    {
+        if (this->RunTask(index))
+            continue;
+
+        unique_lock<mutex> lock(wake_mt);
+        wake.wait(lock, [this]{ return stop or (queued > 0); });
+        if (stop)
+            break;
+    }
+}
+
+void ThreadPool::ParallelFor(int begin, int end, function<void(int)> body)
+{
+    if (end <= begin)
+        return;
+
+    if (end - begin == 1)
+    {
+        body(begin);
+        return;
+    }
+
+    struct Group
+    {
+        atomic<int> remaining;
+        mutex mt;
+        condition_variable done;
+        exception_ptr error;                                            // First exception of the bodies
+    };
+    shared_ptr<Group> group = make_shared<Group>();
+    group->remaining = end - begin;
+
+    for(int i=begin;i<end;i++)
+    {
+        this->Push([group, &body, i]()
+        {
+            // An exception must not leave a worker thread: it is given to
+            // the caller of ParallelFor
+            try
+            {
+                body(i);
+            }
+            catch(...)
+            {
+                lock_guard<mutex> lock(group->mt);
+                if (!group->error)
+                    group->error = current_exception();
+            }
+
+            if (--group->remaining == 0)
+            {
+                lock_guard<mutex> lock(group->mt);
+                group->done.notify_all();
+            }
+        });
+    }
+
+    // Help with the queued tasks, then wait for the ones still running
+    while(group->remaining > 0)
+    {
+        if (this->RunTask(worker_index))
+            continue;
+
+        unique_lock<mutex> lock(group->mt);
+        group->done.wait(lock, [&group]{ return group->remaining == 0; });
+    }
+
+    if (group->error)
+        rethrow_exception(group->error);
+}
@@ -0,0 +1,69 @@
+/*
+ * Traffic Management UAV.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+/*
+ * Persistent thread pool with work stealing.
+ * 
+ * Every worker owns a task queue: it takes its own tasks from the back
+ * and, when it runs out of them, steals from the front of the others.
+ * A thread waiting for a ParallelFor also runs tasks, so nested calls
+ * do not deadlock. The first exception thrown by the loop body is
+ * rethrown by ParallelFor, in the calling thread, once all the
+ * iterations are done.
+ */
+class ThreadPool
+{
+    private:
+        struct Worker
+        {
+            std::deque<std::function<void()> > tasks;
+            std::mutex mt;
+        };
+        std::vector<std::unique_ptr<Worker> > workers;
+        std::vector<std::thread> threads;
+        std::atomic<bool> stop;
+        std::atomic<int> queued;
+        std::atomic<unsigned int> next_worker;
+        std::mutex wake_mt;
+        std::condition_variable wake;
+        void Push(std::function<void()>);
+        bool RunTask(int);
+        void WorkerLoop(int);
+    public:
+        ThreadPool(unsigned int n=0);
+        ~ThreadPool();
+        static ThreadPool& getInstance();
+        unsigned int getSize();
+        void ParallelFor(int, int, std::function<void(int)>);
+};
+
+#endif
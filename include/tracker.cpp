@@ -0,0 +1,90 @@
+/*
+ * Traffic Management UAV.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#include <algorithm>
+
+#include "tracker.h"
+#include "threadpool.h"
+#include "profiler.h"
+
+using namespace std;
+using namespace cv;
+
+TrackerBatch::TrackerBatch(Config &p)
+{
+    config = &p;
+}
+
+TrackerBatch::~TrackerBatch()
+{
+    
+}
+
+bool TrackerBatch::Update(FramePyramid &prev_frame, FramePyramid &frame, BGTracking &bg_tracking,
+                          TrackTable &cars, Mat &f, bool draw_of_vectors)
+{
+    // Gather the keypoints: background first, then the cars (already contiguous)
+    const vector<Point2f> &bg_keypoints = bg_tracking.getKeyPoints();
+    const vector<Point2f> &cars_keypoints = cars.getAllKeyPoints();
+    prev_points.assign(bg_keypoints.begin(), bg_keypoints.end());
+    prev_points.insert(prev_points.end(), cars_keypoints.begin(), cars_keypoints.end());
+    
+    points = prev_points;
+    status.assign(prev_points.size(), 0);
+    if (!prev_points.empty())
+    {
+        PROFILE_SCOPE("track.lk");
+        calcOpticalFlowPyrLK(prev_frame.getOFPyramid(), frame.getOFPyramid(), prev_points,
+                             points, status, err,
+                             config->of_winSize, min(prev_frame.getOFLevels(), frame.getOFLevels()),
+                             config->of_termcrit, 0, 0.001);
+    }
+    
+    // Scatter. The cars speed depends on the background motion.
+    bool bg_tracked;
+    {
+        PROFILE_SCOPE("track.background");
+        bg_tracked = bg_tracking.Update(points.data(), status.data(), f, draw_of_vectors);
+    }
+    
+    {
+        PROFILE_SCOPE("track.cars");
+        int offset = bg_keypoints.size();
+        tracked.resize(cars.getSize());
+        ThreadPool::getInstance().ParallelFor(0, cars.getSize(), [&](int i)
+        {
+            tracked[i] = cars.Update(i, &points[offset + i*CAR_KEYPOINTS], &status[offset + i*CAR_KEYPOINTS],
+                                     bg_tracking, f, false);
+        });
+    }
+    
+    // The workers share the frame, so the cars vectors are drawn afterwards
+    if (draw_of_vectors)
+        for(unsigned int i=bg_keypoints.size();i<points.size();i++)
+            if (status[i])
+                arrowedLine(f, prev_points[i], points[i], Scalar(255,0,255), 2);
+    
+    // Remove the lost cars, from the last one (the swapped in track is already updated)
+    for(int i=cars.getSize()-1;i>=0;i--)
+        if (!tracked[i])
+            cars.Remove(i);
+    
+    return bg_tracked;
+}
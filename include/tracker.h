@@ -0,0 +1,54 @@
+/*
+ * Traffic Management UAV.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#ifndef TRACKER_H_
+#define TRACKER_H_
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include "config.h"
+#include "tracks.h"
+#include "bgtracking.h"
+#include "pyramid.h"
+
+/*
+ * Optical flow of the background and of all the tracked cars.
+ * 
+ * The keypoints are gathered in a single array and tracked with one
+ * Lucas-Kanade call over the shared frame pyramids. The results are
+ * scattered back to BGTracking and to the track table.
+ */
+class TrackerBatch
+{
+    private:
+        Config *config;
+        std::vector<cv::Point2f> prev_points;
+        std::vector<cv::Point2f> points;
+        std::vector<uchar> status;
+        std::vector<float> err;
+        std::vector<char> tracked;
+    public:
+        TrackerBatch(Config&);
+        ~TrackerBatch();
+        bool Update(FramePyramid&, FramePyramid&, BGTracking&, TrackTable&, cv::Mat&, bool);
+};
+
+#endif
@@ -0,0 +1,276 @@
+/*
+ * Traffic Management UAV.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#include <cmath>
+#include <algorithm>
+
+#include "tracks.h"
+
+using namespace std;
+using namespace cv;
+
+TrackTable::TrackTable(Config &p, SensorsData &sd)
+{
+    config = &p;
+    sensors_data = &sd;
+    next_id = 0;
+}
+
+TrackTable::~TrackTable()
+{
+    
+}
+
+int TrackTable::getSize()
+{
+    return ids.size();
+}
+
+unsigned int TrackTable::Add(Rect r)
+{
+    ids.push_back(next_id++);
+    boxes.push_back(r);
+    positions.push_back(Point2f(r.x, r.y));
+    
+    Point2f center = Point2f(r.x+r.width/2,r.y+r.height/2);             // Rect center
+    keypoints.push_back(center);
+    keypoints.push_back(Point2f(center.x - 5, center.y - 5));
+    keypoints.push_back(Point2f(center.x + 5, center.y - 5));
+    keypoints.push_back(Point2f(center.x - 5, center.y + 5));
+    keypoints.push_back(Point2f(center.x + 5, center.y + 5));
+    
+    rect_points.resize(rect_points.size() + RECT_POINTS);
+    modulus.push_back(0);
+    angle.push_back(0);
+    speed.push_back(0);
+    latitude.push_back(0);
+    longitude.push_back(0);
+    
+    this->UpdateRectPoints(ids.size() - 1);
+    
+    return ids.back();
+}
+
+// Swap and pop: the last track takes the place of the removed one
+void TrackTable::Remove(int i)
+{
+    int last = ids.size() - 1;
+    if (i != last)
+    {
+        ids[i] = ids[last];
+        boxes[i] = boxes[last];
+        positions[i] = positions[last];
+        copy(&keypoints[last*CAR_KEYPOINTS], &keypoints[last*CAR_KEYPOINTS] + CAR_KEYPOINTS,
+             &keypoints[i*CAR_KEYPOINTS]);
+        copy(&rect_points[last*RECT_POINTS], &rect_points[last*RECT_POINTS] + RECT_POINTS,
+             &rect_points[i*RECT_POINTS]);
+        modulus[i] = modulus[last];
+        angle[i] = angle[last];
+        speed[i] = speed[last];
+        latitude[i] = latitude[last];
+        longitude[i] = longitude[last];
+    }
+    
+    ids.pop_back();
+    boxes.pop_back();
+    positions.pop_back();
+    keypoints.resize(last*CAR_KEYPOINTS);
+    rect_points.resize(last*RECT_POINTS);
+    modulus.pop_back();
+    angle.pop_back();
+    speed.pop_back();
+    latitude.pop_back();
+    longitude.pop_back();
+}
+
+void TrackTable::Clear()
+{
+    ids.clear();
+    boxes.clear();
+    positions.clear();
+    keypoints.clear();
+    rect_points.clear();
+    modulus.clear();
+    angle.clear();
+    speed.clear();
+    latitude.clear();
+    longitude.clear();
+}
+
+void TrackTable::UpdateRectPoints(int i)
+{
+    Rect &r = boxes[i];
+    Point2f *p = &rect_points[i*RECT_POINTS];
+    p[0] = Point2f(r.x, r.y);
+    p[1] = Point2f(r.x + r.width, r.y);
+    p[2] = Point2f(r.x + r.width, r.y + r.height);
+    p[3] = Point2f(r.x, r.y + r.height);
+    p[4] = Point2f(r.x + r.width/2, r.y);
+    p[5] = Point2f(r.x + r.width, r.y + r.height);
+    p[6] = Point2f(r.x + r.width/2, r.y + r.height);
+    p[7] = Point2f(r.x, r.y + r.height/2);
+}
+
+unsigned int TrackTable::getId(int i)
+{
+    return ids[i];
+}
+
+Rect TrackTable::getRect(int i)
+{
+    return boxes[i];
+}
+
+Point2f TrackTable::getPosition(int i)
+{
+    return positions[i];
+}
+
+const Point2f* TrackTable::getKeyPoints(int i)
+{
+    return &keypoints[i*CAR_KEYPOINTS];
+}
+
+const vector<Point2f>& TrackTable::getAllKeyPoints()
+{
+    return keypoints;
+}
+
+const Point2f* TrackTable::getRectPoints(int i)
+{
+    return &rect_points[i*RECT_POINTS];
+}
+
+double TrackTable::getSpeed(int i)
+{
+    return speed[i];
+}
+
+double TrackTable::getLatitude(int i)
+{
+    return latitude[i];
+}
+
+double TrackTable::getLongitude(int i)
+{
+    return longitude[i];
+}
+
+double TrackTable::getModulus(int i)
+{
+    return modulus[i];
+}
+
+double TrackTable::getAngle(int i)
+{
+    return angle[i];
+}
+
+bool TrackTable::Update(int i, const Point2f *new_car_keypoints, const uchar *status, BGTracking &bg_tracking, Mat &f, bool draw_of_vectors)
+{
+    Point2f *car_keypoints = &keypoints[i*CAR_KEYPOINTS];
+    
+    positions[i] = Point2f(new_car_keypoints[0].x-13, new_car_keypoints[0].y-25);
+    boxes[i] = Rect(positions[i].x, positions[i].y, boxes[i].width, boxes[i].height);
+    this->UpdateRectPoints(i);
+    
+    double m = 0;
+    double a = 0;
+    int counter = 0;
+    for(int j=0;j<CAR_KEYPOINTS;j++)
+    {
+        if (status[j])
+        {
+            if (draw_of_vectors)
+                arrowedLine(f, car_keypoints[j], new_car_keypoints[j], Scalar(255,0,255), 2);
+            m += sqrt(pow(car_keypoints[j].x - new_car_keypoints[j].x, 2) +
+                      pow(car_keypoints[j].y - new_car_keypoints[j].y, 2));
+            double ang = atan2(car_keypoints[j].y - new_car_keypoints[j].y,
+                               car_keypoints[j].x - new_car_keypoints[j].x);
+            if (ang < 0)
+                ang += 2*M_PI;
+            a += ang;
+            counter++;
+        }
+    }
+    if (counter > 2)
+    {
+        m /= counter;
+        a /= counter;
+    }
+    else
+        return false;
+    modulus[i] = m;
+    angle[i] = a;
+    
+	// A still car
+    if ((m <= bg_tracking.getModulus()*1.15) and (m >= bg_tracking.getModulus()*0.85))
+        speed[i] = 0;
+    // A car moving at the same speed
+    else if (m <= config->equal_speed_threshold)
+		speed[i] = sensors_data->speed;
+    else
+    {
+        if ((bg_tracking.getAngle()*1.2 >= a) and (bg_tracking.getAngle()*0.8 <=  a))
+        {
+			speed[i] = (sensors_data->speed*m/bg_tracking.getModulus()) - sensors_data->speed;
+        }
+        else if (((bg_tracking.getAngle()-M_PI)*1.2 >= a) and ((bg_tracking.getAngle()-M_PI)*0.8 <=  a))
+			speed[i] = (sensors_data->speed*m/bg_tracking.getModulus()) + sensors_data->speed;
+        else
+			speed[i] = (sensors_data->speed*m/bg_tracking.getModulus());
+    }
+    
+    copy(new_car_keypoints, new_car_keypoints + CAR_KEYPOINTS, car_keypoints);
+    
+    return true;
+}
+
+void TrackTable::CalcRealPos(int k, Mat &frame, SensorsData &sensors_data, Camera &cam)
+{
+    int i = positions[k].x - frame.cols/2;
+    int j = positions[k].y - frame.rows/2;
+    double h = sensors_data.altitude;
+    double f = cam.focal_lenght;
+    double theta = sensors_data.roll;
+    double phi = sensors_data.pitch;
+    double ps = cam.pixel_size;
+    double lat1 = sensors_data.latitude*M_PI/180;
+	double lon1 = sensors_data.longitude*M_PI/180;
+    double heading = sensors_data.heading*M_PI/180;
+    
+    double x_c = ps*j*h/(j*sin(theta) + cos(theta)*(f*cos(phi) + i*sin(phi)));
+    double y_c = ps*i*h/(j*sin(theta) + cos(theta)*(f*cos(phi) + i*sin(phi)));
+    double z_c = f*h/(j*sin(theta) + cos(theta)*(f*cos(phi) + i*sin(phi)));
+    
+    // Distance
+	double d = sqrt(pow(x_c,2) + pow(y_c,2));
+	
+	// Angular distance
+	double delta = d/R;
+	
+	double bearing = heading - (270*M_PI/180) + atan2(x_c, y_c);
+	
+	double lat2 = asin(sin(lat1)*cos(delta) + cos(lat1)*sin(delta)*cos(bearing));
+    double lon2 = lon1 + atan2(sin(bearing)*sin(delta)*cos(lat1), cos(delta) - sin(lat1)*sin(lat2));
+    
+    latitude[k] = lat2*180/M_PI;
+    longitude[k] = lon2*180/M_PI;
+}
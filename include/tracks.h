@@ -0,0 +1,88 @@
+/*
+ * Traffic Management UAV.
+ * 
+ * Copyright (c) 2016 Gabriel Mariano Marcelino <gabriel.mm8@gmail.com>
+ * 
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>
+ * 
+ */
+
+#ifndef TRACKS_H_
+#define TRACKS_H_
+
+#include <vector>
+#include <opencv2/opencv.hpp>
+
+#include "config.h"
+#include "sensors_data.h"
+#include "camera.h"
+#include "bgtracking.h"
+
+// Earth radius
+#define R 6371000
+
+// Number of optical flow keypoints of each car
+#define CAR_KEYPOINTS 5
+
+// Number of points of the bounding box returned by getRectPoints()
+#define RECT_POINTS 8
+
+/*
+ * Table of the tracked cars.
+ * 
+ * Each field is stored in its own array (structure of arrays), indexed
+ * by the track position. A removed track is replaced by the last one,
+ * so the positions change but the track ids are kept. The arrays keep
+ * their capacity, and the tracking loop does not allocate memory.
+ */
+class TrackTable
+{
+    private:
+        Config *config;
+        SensorsData *sensors_data;
+        unsigned int next_id;
+        std::vector<unsigned int> ids;
+        std::vector<cv::Rect> boxes;
+        std::vector<cv::Point2f> positions;
+        std::vector<cv::Point2f> keypoints;                             // CAR_KEYPOINTS per track
+        std::vector<cv::Point2f> rect_points;                           // RECT_POINTS per track
+        std::vector<double> modulus;
+        std::vector<double> angle;
+        std::vector<double> speed;
+        std::vector<double> latitude;
+        std::vector<double> longitude;
+        void UpdateRectPoints(int);
+    public:
+        TrackTable(Config&, SensorsData&);
+        ~TrackTable();
+        int getSize();
+        unsigned int Add(cv::Rect);
+        void Remove(int);
+        void Clear();
+        unsigned int getId(int);
+        cv::Rect getRect(int);
+        cv::Point2f getPosition(int);
+        const cv::Point2f* getKeyPoints(int);
+        const std::vector<cv::Point2f>& getAllKeyPoints();
+        const cv::Point2f* getRectPoints(int);
+        double getSpeed(int);
+        double getLatitude(int);
+        double getLongitude(int);
+        double getModulus(int);
+        double getAngle(int);
+        bool Update(int, const cv::Point2f*, const uchar*, BGTracking&, cv::Mat&, bool);
+        void CalcRealPos(int, cv::Mat&, SensorsData&, Camera&);
+};
+
+#endif
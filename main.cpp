@@ -21,16 +21,22 @@
 #include <iostream>
 #include <vector>
 #include <chrono>
-#include <thread>
+#include <string>
+#include <memory>
+#include <cstdlib>
+#include <getopt.h>
 #include <opencv2/opencv.hpp>
 
-#include "include/car.h"
+#include "include/tracks.h"
 #include "include/detect.h"
 #include "include/aux.h"
 #include "include/bgtracking.h"
 #include "include/config.h"
 #include "include/sensors_data.h"
 #include "include/camera.h"
+#include "include/pipeline.h"
+#include "include/output.h"
+#include "include/profiler.h"
 
 //#define VIDEO_OUTPUT 1
 
@@ -39,10 +45,121 @@ using namespace cv;
 using namespace cv::ml;
 using namespace std::chrono;
 
+void Usage(char *name)
+{
+    cout << "Usage: " << name << " [options] video" << endl;
+    cout << "  -p, --pipeline         Run the processing stages in parallel threads" << endl;
+    cout << "  -H, --headless         No GUI and no rendering, only the tracks output" << endl;
+    cout << "  -o, --output FILE      Tracks output (standard output by default)" << endl;
+    cout << "  -f, --format FORMAT    Tracks output format: jsonl (default) or csv" << endl;
+    cout << "  -s, --svm FILE         Trained SVM (hog-svm-cars.xml by default)" << endl;
+    cout << "  -t, --threshold VALUE  SVM hyperplane distance of a detection" << endl;
+    cout << "  -v, --variance VALUE   Minimum variance of a detection window" << endl;
+    cout << "  -n, --frames N         Process at most N frames" << endl;
+    cout << "  -P, --profile          Print the stages latency percentiles at the end" << endl;
+    cout << "  -T, --trace FILE       Write the stages timeline as a Chrome trace" << endl;
+    cout << "  -h, --help             Show this help" << endl;
+}
+
 int main(int argc, char **argv)
 {
+    // Command line options
+    bool pipelined = false;
+    bool headless = false;
+    string output_path;
+    string output_format;
+    string svm_path = "hog-svm-cars.xml";
+    bool set_threshold = false;
+    float threshold = 0;
+    bool set_variance = false;
+    int variance = 0;
+    unsigned int max_frames = 0;
+    bool profile = false;
+    string trace_path;
+    
+    const struct option long_options[] =
+    {
+        {"pipeline", no_argument, 0, 'p'},
+        {"headless", no_argument, 0, 'H'},
+        {"output", required_argument, 0, 'o'},
+        {"format", required_argument, 0, 'f'},
+        {"svm", required_argument, 0, 's'},
+        {"threshold", required_argument, 0, 't'},
+        {"variance", required_argument, 0, 'v'},
+        {"frames", required_argument, 0, 'n'},
+        {"profile", no_argument, 0, 'P'},
+        {"trace", required_argument, 0, 'T'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+    
+    int opt;
+    while((opt = getopt_long(argc, argv, "pHo:f:s:t:v:n:PT:h", long_options, 0)) != -1)
+    {
+        switch(opt)
+        {
+            case 'p':
+                pipelined = true;
+                break;
+            case 'H':
+                headless = true;
+                break;
+            case 'o':
+                output_path = optarg;
+                break;
+            case 'f':
+                output_format = optarg;
+                break;
+            case 's':
+                svm_path = optarg;
+                break;
+            case 't':
+                set_threshold = true;
+                threshold = atof(optarg);
+                break;
+            case 'v':
+                set_variance = true;
+                variance = atoi(optarg);
+                break;
+            case 'n':
+                max_frames = atoi(optarg);
+                break;
+            case 'P':
+                profile = true;
+                break;
+            case 'T':
+                trace_path = optarg;
+                break;
+            case 'h':
+                Usage(argv[0]);
+                return 0;
+            default:
+                Usage(argv[0]);
+                return -1;
+        }
+    }
+    
+    if (optind != argc - 1)
+    {
+        Usage(argv[0]);
+        return -1;
+    }
+    
+    // CSV when asked or by the output file extension, JSON lines otherwise
+    if (output_format.empty())
+        output_format = ((output_path.size() > 4) and
+                         (output_path.substr(output_path.size() - 4) == ".csv"))? "csv":"jsonl";
+    if ((output_format != "jsonl") and (output_format != "csv"))
+    {
+        cout << "Unknown output format: " << output_format << endl;
+        return -1;
+    }
+    
+    if (profile or !trace_path.empty())
+        Profiler::getInstance().Enable(!trace_path.empty());
+    
     // Opening the file capture
-    VideoCapture cap(argv[1]);
+    VideoCapture cap(argv[optind]);
     if (!cap.isOpened())
     {
         cout << "Error opening the capture" << endl;
@@ -50,16 +167,18 @@ int main(int argc, char **argv)
     }
     
     // Load trained SVM data
-    Ptr<SVM> svm = SVM::load<SVM>("hog-svm-cars.xml");
+    Ptr<SVM> svm = SVM::load<SVM>(svm_path);
+    LinearCarClassifier classifier(svm);
     
-    Mat frame;
-    Mat gray_frame;
     Mat prev_frame;
-    Mat prev_gray_frame;
     
     // Get the first frame for a initial setup
     cap >> prev_frame;
-    cvtColor(prev_frame, prev_gray_frame, CV_BGR2GRAY);
+    if (prev_frame.empty())
+    {
+        cout << "Error reading the first frame" << endl;
+        return -1;
+    }
     
     // Set camera specs
     Camera cam_specs(Size(1920, 1080), 0.004, 2.8e-6);
@@ -67,37 +186,22 @@ int main(int argc, char **argv)
     // Set config parameters
     Config config;
     Setup(config, prev_frame);
+    if (set_threshold)
+        config.svm_min_hyperplane_distance = threshold;
+    if (set_variance)
+        config.variance_threshold = variance;
     
     // Initial sensors read
     SensorsData sensors_data;
     ReadSensors(sensors_data);
 
     // Set ROIs
-    vector<Rect> initial_roi;
-    initial_roi.push_back(Rect(0, 0, prev_frame.cols, prev_frame.rows));
-
     vector<Rect> rois;
     rois.push_back(Rect(200, 0, prev_frame.cols-400, 100));
     rois.push_back(Rect(200, prev_frame.rows-100, prev_frame.cols-400, 100));
 
-    vector<Rect> rois1;
-    rois1.push_back(rois[0]);
-
-    vector<Rect> rois2;
-    rois2.push_back(rois[1]);
-
-    // Detect the cars in first frame
-    vector<Car> cars;
-    DetectCars(prev_gray_frame, svm, config, sensors_data, cars,
-               initial_roi, VERTICAL_SEARCH);
-
-    // Finding keypoints in first frame
-    vector<Point2f> keypoints = DetectKeyPoints(prev_gray_frame, config);
-    
-    // Classify keypoints
-    ClassifingKeyPoints(keypoints, cars);
-        
-    BGTracking bg_tracking(keypoints, config);
+    // Detect the cars and the background keypoints in first frame
+    FramePipeline pipeline(prev_frame, classifier, config, sensors_data, rois);
     
     // Output record
     #ifdef VIDEO_OUTPUT
@@ -105,73 +209,84 @@ int main(int argc, char **argv)
                           prev_frame.size(), true);
     #endif
     
-    unsigned int frame_counter = 0;
-    while(true)
+    // Tracks record
+    unique_ptr<TrackWriter> writer;
+    if (headless or !output_path.empty())
     {
-        auto t0 = high_resolution_clock::now();
-        cap >> frame;
-        if (frame.empty())
-            break;
-        
-        cvtColor(frame, gray_frame, CV_BGR2GRAY);
-        
-        // Update background tracking
-        if (!bg_tracking.Update(prev_gray_frame, gray_frame, frame, false) or (frame_counter == config.frames_to_update))
+        writer.reset(new TrackWriter(output_path, (output_format == "csv")? OUTPUT_CSV:OUTPUT_JSONL));
+        if (!writer->isOpened())
         {
-            vector<Point2f> keypoints = DetectKeyPoints(gray_frame, config);
-            ClassifingKeyPoints(keypoints, cars);
-            bg_tracking.setKeyPoints(keypoints);
-            frame_counter = 0;
+            cerr << "Error opening the output " << output_path << endl;
+            return -1;
         }
-
-        // Search for new cars
-        vector<Car> cars2 = cars;
-        int cars_size = cars.size();
-        thread detect_cars_thread1(DetectCars, ref(gray_frame), svm, ref(config),
-											   ref(sensors_data), ref(cars), ref(rois1),
-                                               VERTICAL_SEARCH);
-        thread detect_cars_thread2(DetectCars, ref(gray_frame), svm, ref(config),
-                                               ref(sensors_data), ref(cars2), ref(rois2),
-                                               VERTICAL_SEARCH);
-        detect_cars_thread1.join();
-        detect_cars_thread2.join();
-        
-        for(unsigned int i=cars_size;i<cars2.size();i++)
-            cars.push_back(cars2[i]);
+    }
+    
+    unsigned int frames = 0;
+    auto start = high_resolution_clock::now();
+    auto t0 = start;
+    auto render = [&](FramePacket &packet) -> bool
+    {
+        if (writer)
+        {
+            PROFILE_SCOPE("output");
+            for(int i=0;i<packet.cars.getSize();i++)
+                packet.cars.CalcRealPos(i, packet.frame, sensors_data, cam_specs);
+            writer->Write(packet.number, packet.cars);
+        }
+        frames++;
         
-        // Update cars tracking
-        for(unsigned int i=0;i<cars.size();i++)
-            if (!cars[i].Update(prev_gray_frame, gray_frame, bg_tracking, frame, false))
+        if (!headless)
+        {
+            // Draw results
+            Mat result;
             {
-                cars.erase(cars.begin()+i);
-                i--;
+                PROFILE_SCOPE("draw");
+                result = DrawResults(packet.frame, packet.cars, packet.bg_tracking, sensors_data, config);
             }
 
-        // Draw results
-        Mat result = DrawResults(frame, cars, bg_tracking, sensors_data, config);
-
-        //result = DrawKeyPoints(frame, bg_tracking.getKeyPoints(), Scalar(0,0,255));
-        //result = DrawCarsKeyPoints(frame, cars, Scalar(0,255,255));
-        //result = DrawROIs(result, rois);
+            //result = DrawKeyPoints(packet.frame, packet.bg_tracking.getKeyPoints(), Scalar(0,0,255));
+            //result = DrawCarsKeyPoints(packet.frame, packet.cars, Scalar(0,255,255));
+            //result = DrawROIs(result, rois);
 
-        auto t1 = high_resolution_clock::now();
+            // Frames rate at the output (in the pipelined mode the stages overlap)
+            auto t1 = high_resolution_clock::now();
+            double frame_time = duration_cast<microseconds>(t1-t0).count();
+            double fps = 1e6/max(frame_time, 1.0);
+            t0 = t1;
 
-        #ifndef VIDEO_OUTPUT
-        result = WriteFPS(result, 1000/double(duration_cast<milliseconds>(t1-t0).count()));
-        
-        imshow("Traffic management UAV", result);
-        char d = waitKey(1);
-        if (d == 'q')
-            break;
-        if (d == 's')
-            imwrite("print.png", result);
-        #else
-        capOutput << result;
-        #endif
+            PROFILE_SCOPE("display");
+            #ifndef VIDEO_OUTPUT
+            result = WriteFPS(result, fps);
+            
+            imshow("Traffic management UAV", result);
+            char d = waitKey(1);
+            if (d == 'q')
+                return false;
+            if (d == 's')
+                imwrite("print.png", result);
+            #else
+            capOutput << result;
+            #endif
+        }
         
-        swap(prev_gray_frame, gray_frame);
-        frame_counter++;
-    }
+        return (max_frames == 0) or (frames < max_frames);
+    };
+    
+    if (pipelined)
+        pipeline.RunPipelined(cap, render);
+    else
+        pipeline.Run(cap, render);
+    
+    // Throughput summary (the standard output may hold the tracks)
+    double seconds = duration_cast<microseconds>(high_resolution_clock::now() - start).count()/1e6;
+    cerr << frames << " frames in " << seconds << " s (" << frames/max(seconds, 1e-6) << " fps, "
+         << (pipelined? "pipelined":"sequential") << ")" << endl;
+    
+    // Stages latency
+    if (profile)
+        Profiler::getInstance().PrintSummary(cerr);
+    if (!trace_path.empty() and !Profiler::getInstance().WriteTrace(trace_path))
+        cout << "Error writing the trace " << trace_path << endl;
 
     cap.release();
     